@@ -29,14 +29,58 @@
 #include "CompositeSolid.h"
 #include "input.h"
 #include "geomtools.h"
+#include "validate_prim_toporel.h"
+
+#include <unordered_map>
+#include <algorithm>
 
 namespace val3dity
 {
 
+//-- the bbox of a solid is a fingerprint of its point set: 2 solids that are 
+//-- geometrically equal have the same bbox, whatever their faces are
+struct BboxHash {
+  std::size_t operator()(const std::array<double, 6>& b) const
+  {
+    std::size_t h = 0;
+    for (auto& v : b)
+      h ^= std::hash<double>()(v) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+  }
+};
+
+
+//-- canonical form of the boundary of a solid: each triangle is the cycle of its 
+//-- vertices starting at the smallest one, and the triangles are sorted. 2 solids with 
+//-- the same form are equal (not the reverse: their surfaces can be split differently)
+static std::vector<std::vector<Point3>> get_canonical_boundary(Solid* s)
+{
+  std::vector<std::vector<Point3>> re;
+  for (auto& sh : s->get_shells())
+  {
+    CgalPolyhedron* p = sh->get_cgal_polyhedron();
+    for (auto f = p->facets_begin(); f != p->facets_end(); f++)
+    {
+      std::vector<Point3> cycle;
+      auto h = f->facet_begin();
+      do {
+        cycle.push_back(h->vertex()->point());
+      } while (++h != f->facet_begin());
+      std::rotate(cycle.begin(), std::min_element(cycle.begin(), cycle.end()), cycle.end());
+      re.push_back(cycle);
+    }
+  }
+  std::sort(re.begin(), re.end());
+  return re;
+}
+
+bool CompositeSolid::_corefinement = false;
+
 CompositeSolid::CompositeSolid(std::string id)
 {
   _id = id;
   _is_valid = -1;
+  _nef = NULL;
 }
 
 
@@ -62,15 +106,39 @@ Nef_polyhedron* CompositeSolid::get_nef_polyhedron()
   Nef_polyhedron* unioned = new Nef_polyhedron(Nef_polyhedron::EMPTY);
   for (int i = 0; i < _lsSolids.size(); i++)
   {
+    //-- the Nef of each Solid is owned (and cached) by the Solid
     Nef_polyhedron* tmp = _lsSolids[i]->get_nef_polyhedron();
     *unioned = *unioned + *tmp;
-    delete tmp;
   }
   _nef = unioned;
   return unioned;
 }
 
 
+CGAL::Bbox_3 CompositeSolid::get_bbox()
+{
+  CGAL::Bbox_3 bbox;
+  for (auto& s : _lsSolids)
+    bbox += s->get_bbox();
+  return bbox;
+}
+
+
+void CompositeSolid::release_nef_polyhedra()
+{
+  delete _nef;
+  _nef = NULL;
+  for (auto& s : _lsSolids)
+    s->release_nef_polyhedra();
+}
+
+
+void CompositeSolid::set_overlap_with_corefinement(bool corefinement)
+{
+  _corefinement = corefinement;
+}
+
+
 void CompositeSolid::get_min_bbox(double& x, double& y)
 {
   double tmpx, tmpy;
@@ -106,47 +174,83 @@ bool CompositeSolid::validate(double tol_planarity_d2p, double tol_planarity_nor
   }
   if (isValid == true) 
   {
-    std::vector<Nef_polyhedron*> lsNefs;
-    for (int i = 0; i < _lsSolids.size(); i++)
-      lsNefs.push_back(_lsSolids[i]->get_nef_polyhedron());
 //-- 1. check if any 2 are the same? ERROR:502
     // std::clog << "-----Are two solids duplicated" << std::endl;
-    for (int i = 0; i < (lsNefs.size() - 1); i++)
+    //-- only the solids with the same bbox are compared: first with their canonical
+    //-- boundaries, and if these differ then with their Nef polyhedra
+    std::unordered_map<std::array<double, 6>, std::vector<int>, BboxHash> groups;
+    for (int i = 0; i < _lsSolids.size(); i++)
+    {
+      CGAL::Bbox_3 b = _lsSolids[i]->get_bbox();
+      groups[{b.xmin(), b.ymin(), b.zmin(), b.xmax(), b.ymax(), b.zmax()}].push_back(i);
+    }
+    std::vector<std::pair<int, int>> duplicates;
+    for (auto& g : groups)
     {
-      for (int j = i + 1; j < lsNefs.size(); j++) 
+      std::vector<int>& ids = g.second;
+      if (ids.size() < 2)
+        continue;
+      std::vector<std::vector<std::vector<Point3>>> forms;
+      for (auto& i : ids)
+        forms.push_back(get_canonical_boundary(_lsSolids[i]));
+      for (int a = 0; a < (ids.size() - 1); a++)
       {
-        if (*lsNefs[i] == *lsNefs[j])
+        for (int b = a + 1; b < ids.size(); b++) 
         {
-          std::stringstream msg1, msg2;
-          msg1 << "Geometry (CompositeSolid) #" << this->get_id();
-          msg2 << "solid=" << _lsSolids[i]->get_id() << "&&solid=" << _lsSolids[j]->get_id();
-          this->add_error(502, msg1.str(), msg2.str());
-          isValid = false;
+          if ( (forms[a] == forms[b]) || 
+               (*(_lsSolids[ids[a]]->get_nef_polyhedron()) == *(_lsSolids[ids[b]]->get_nef_polyhedron())) )
+            duplicates.push_back(std::make_pair(ids[a], ids[b]));
         }
       }
     }
-    if (isValid == true)
+    std::sort(duplicates.begin(), duplicates.end());
+    for (auto& d : duplicates)
     {
-//-- 2. check if their interior intersects ERROR:501
-      // std::clog << "-----Intersections of solids" << std::endl;
-      std::vector<Nef_polyhedron*> lsNefsEroded;
-      if (tol_overlap > 0.0)
+      std::stringstream msg1, msg2;
+      msg1 << "Geometry (CompositeSolid) #" << this->get_id();
+      msg2 << "solid=" << _lsSolids[d.first]->get_id() << "&&solid=" << _lsSolids[d.second]->get_id();
+      this->add_error(502, msg1.str(), msg2.str());
+      isValid = false;
+    }
+    if ( (isValid == true) && 
+         ( (_corefinement == true) || ((tol_overlap > 0.0) && (get_overlap_tol_with_distances() == true)) ) )
+    {
+//-- 2. check if their interior intersects ERROR:501 (with the triangle meshes)
+      std::vector<std::pair<int, int>> overlaps;
+      if (_corefinement == true)
+        find_solids_interior_overlap_corefinement(_lsSolids, overlaps, tol_overlap);
+      else
+        find_solids_interior_overlap_distances(_lsSolids, overlaps, tol_overlap);
+      for (auto& pr : overlaps)
       {
-        for (auto each : lsNefs)
-          lsNefsEroded.push_back(erode_nef_polyhedron(each, tol_overlap));
+        std::stringstream msg1, msg2;
+        msg1 << "Geometry (CompositeSolid) #" << this->get_id();
+        msg2 << "solid=" << _lsSolids[pr.first]->get_id() << "&&solid=" << _lsSolids[pr.second]->get_id();
+        this->add_error(501, msg1.str(), msg2.str());
+        isValid = false;
       }
-      else
+    }
+    else if (isValid == true)
+    {
+//-- 2. check if their interior intersects ERROR:501
+      // std::clog << "-----Intersections of solids" << std::endl;
+      //-- the Nefs are handles: the ones of the Solids are shared, not copied
+      std::vector<Nef_polyhedron> lsNefsEroded;
+      for (auto& sol : _lsSolids)
       {
-        lsNefsEroded = lsNefs;
+        if (tol_overlap > 0.0)
+          lsNefsEroded.push_back(sol->get_eroded_nef_polyhedron(tol_overlap));
+        else
+          lsNefsEroded.push_back(*(sol->get_nef_polyhedron()));
       }
       Nef_polyhedron emptynef(Nef_polyhedron::EMPTY);
       for (int i = 0; i < (lsNefsEroded.size() - 1); i++)
       {
-        Nef_polyhedron* a = lsNefsEroded[i];
+        const Nef_polyhedron& a = lsNefsEroded[i];
         for (int j = i + 1; j < lsNefsEroded.size(); j++) 
         {
-          Nef_polyhedron* b = lsNefsEroded[j];
-          if (a->interior() * b->interior() != emptynef)
+          const Nef_polyhedron& b = lsNefsEroded[j];
+          if (a.interior() * b.interior() != emptynef)
           {
             std::stringstream msg1, msg2;
             msg1 << "Geometry (CompositeSolid) #" << this->get_id();
@@ -156,46 +260,22 @@ bool CompositeSolid::validate(double tol_planarity_d2p, double tol_planarity_nor
           }
         }
       }
-      if (tol_overlap > 0.0)
-      {
-        for (auto each : lsNefsEroded)
-          delete each;
-      }
     }
     if (isValid == true)
     {
 //-- 3. check if their union yields one solid ERROR:503
       // std::clog << "-----Forming one solid (union)" << std::endl;
-      std::vector<Nef_polyhedron*> lsNefsDilated;
-      if (tol_overlap > 0.0)
-      {
-        for (auto each : lsNefs)
-          lsNefsDilated.push_back(dilate_nef_polyhedron(each, tol_overlap));
-      }
-      else
-      {
-        lsNefsDilated = lsNefs;
-      }
-      Nef_polyhedron unioned(Nef_polyhedron::EMPTY);
-      for (auto each : lsNefsDilated)
-        unioned = unioned + *each;
-      if (unioned.number_of_volumes() != 2)
+      //-- the solids in contact are the edges of a graph, it must have one component
+      int noparts = get_number_connected_solids(_lsSolids, tol_overlap);
+      if (noparts != 1)
       {
         std::stringstream msg1, msg2;
         msg1 << "Geometry (CompositeSolid) #" << this->get_id();
-        msg2 << "CompositeSolid is formed of " << (unioned.number_of_volumes() - 1) << " parts";
+        msg2 << "CompositeSolid is formed of " << noparts << " parts";
         this->add_error(503, msg1.str(), msg2.str());
         isValid = false;
       }
-      for (auto each : lsNefsDilated)
-        delete each;
     } 
-    //-- clear the temp Nefs
-    if (tol_overlap > 0.0)
-    {
-      for (auto each: lsNefs)
-        delete each;
-    }
   }
   _is_valid = isValid;
   return isValid;
@@ -55,6 +55,10 @@ public:
   void          translate_vertices();
 
   Nef_polyhedron* get_nef_polyhedron();
+  CGAL::Bbox_3  get_bbox();
+  void          release_nef_polyhedra();
+
+  static void   set_overlap_with_corefinement(bool corefinement);
 
   bool          add_solid(Solid* s);
   int           number_of_solids();
@@ -62,6 +66,7 @@ public:
 protected:
   std::vector<Solid*> _lsSolids;
   Nef_polyhedron*     _nef;
+  static bool         _corefinement; //-- corefinement of meshes instead of Nefs for 501
 };
 
 } // namespace val3dity
@@ -38,8 +38,10 @@ Feature::Feature() {
 }
 
 Feature::~Feature() {
+  //-- GeometryTemplates are shared by several Features, not owned by them
   for (auto& p : _lsPrimitives) {
-    delete p;
+    if (p->get_type() != GEOMETRYTEMPLATE)
+      delete p;
   }
 
 }
@@ -98,6 +100,16 @@ void Feature::add_primitive(Primitive* p)
   _lsPrimitives.push_back(p);
 }
 
+//-- frees the Nef polyhedra cached by the primitives once the Feature is validated
+//-- (GeometryTemplates are shared by several Features and are not touched)
+void Feature::release_nef_polyhedra()
+{
+  for (auto& p : _lsPrimitives) {
+    if (p->get_type() != GEOMETRYTEMPLATE)
+      p->release_nef_polyhedra();
+  }
+}
+
 int Feature::number_of_primitives() 
 {
   return _lsPrimitives.size();
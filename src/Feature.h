@@ -57,6 +57,7 @@ public:
   bool                    is_empty();
   
   void                    add_primitive(Primitive* p);
+  void                    release_nef_polyhedra();
 
   const std::vector<Primitive*>&  get_primitives();
 
@@ -47,6 +47,11 @@ Primitive3D GeometryTemplate::get_type()
 
 bool GeometryTemplate::validate(double tol_planarity_d2p, double tol_planarity_normals, double tol_overlap) 
 {
+  //-- a template is shared by several Features (perhaps validated by
+  //-- different threads), so it's validated only once
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_is_valid != -1)
+    return (_is_valid == 1);
   bool isValid = true;
   for (auto& p : _lsPrimitives)
   {
@@ -34,6 +34,7 @@
 
 #include <string>
 #include <vector>
+#include <mutex>
 
 namespace val3dity
 {
@@ -58,6 +59,7 @@ public:
 
 protected:
   std::vector<Primitive*> _lsPrimitives;
+  std::mutex              _mutex;
 };
 
 } // namespace val3dity
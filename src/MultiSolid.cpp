@@ -143,4 +143,9 @@ int MultiSolid::number_of_solids() {
   return _lsSolids.size();
 }
 
+void MultiSolid::release_nef_polyhedra() {
+  for (auto& s : _lsSolids)
+    s->release_nef_polyhedra();
+}
+
 } // namespace val3dity
@@ -54,6 +54,8 @@ public:
   void          get_min_bbox(double& x, double& y);
   void          translate_vertices();
 
+  void          release_nef_polyhedra();
+
   bool          add_solid(Solid* s);
   int           number_of_solids();
 
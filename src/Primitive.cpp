@@ -43,6 +43,10 @@ Primitive::Primitive() {
 Primitive::~Primitive() {
 }
 
+//-- by default a primitive has no Nef polyhedra to free
+void Primitive::release_nef_polyhedra() {
+}
+
 void Primitive::set_translation_min_values(double minx, double miny)
 {
   Primitive::_shiftx = minx;
@@ -56,6 +56,7 @@ public:
 
   virtual void          get_min_bbox(double& x, double& y) = 0;
   virtual void          translate_vertices() = 0;
+  virtual void          release_nef_polyhedra();
   static void           set_translation_min_values(double minx, double miny);
 
   std::string           get_id();
@@ -32,6 +32,11 @@
 
 #include "input.h"
 #include "validate_shell.h"
+#include "geomtools.h"
+
+#include <CGAL/Polygon_mesh_processing/intersection.h>
+#include <CGAL/Side_of_triangle_mesh.h>
+#include <memory>
 
 namespace val3dity
 {
@@ -41,12 +46,13 @@ Solid::Solid(std::string id)
   _id = id;
   _is_valid = -1;
   _nef = NULL;
+  _convex = -1;
 }
 
 
 Solid::~Solid()
 {
-  delete _nef;
+  this->release_nef_polyhedra();
   for (auto& sh : _shells) {
     delete sh;
   }
@@ -215,24 +221,92 @@ Nef_polyhedron* Solid::get_nef_polyhedron()
 {
   if (_nef != NULL)
     return _nef;
-  std::vector<Nef_polyhedron> nefs;
-  for (auto& sh : this->get_shells())
+  Nef_polyhedron* re = new Nef_polyhedron(*(this->get_nef_shell(0)));
+  for (int i = 1; i <= this->num_ishells(); i++) 
+  {
+    *re -= *(this->get_nef_shell(i));
+  }
+  _nef = re;
+  return re;
+}
+
+
+//-- a (valid) Solid without inner shells is convex if all its vertices are on the 
+//-- inner side of the plane of each of its faces
+bool Solid::is_convex()
+{
+  if (_convex != -1)
+    return (_convex == 1);
+  if (this->is_valid() != 1)
+    return false;
+  _convex = 0;
+  if (this->num_ishells() > 0)
+    return false;
+  CgalPolyhedron* p = this->get_oshell()->get_cgal_polyhedron();
+  for (auto f = p->facets_begin(); f != p->facets_end(); f++)
+  {
+    auto h = f->facet_begin();
+    const Point3& p0 = h->vertex()->point();
+    const Point3& p1 = h->next()->vertex()->point();
+    const Point3& p2 = h->next()->next()->vertex()->point();
+    for (auto v = p->vertices_begin(); v != p->vertices_end(); v++)
+    {
+      if (CGAL::orientation(p0, p1, p2, v->point()) == CGAL::POSITIVE)
+        return false;
+    }
+  }
+  _convex = 1;
+  return true;
+}
+
+
+//-- erosion (and dilation) by a cube of half-size r, a new Nef (a handle, the Nef of
+//-- the Solid is not modified): convex solids are offset with their planes, the 
+//-- others use Minkowski sums
+Nef_polyhedron Solid::get_eroded_nef_polyhedron(float r)
+{
+  Nef_polyhedron re;
+  if ( (this->is_convex() == true) && 
+       (erode_convex_polyhedron(this->get_oshell()->get_cgal_polyhedron(), r, 64, re) == true) )
+    return re;
+  return erode_nef_polyhedron(*(this->get_nef_polyhedron()), r);
+}
+
+
+Nef_polyhedron Solid::get_dilated_nef_polyhedron(float r)
+{
+  if (this->is_convex() == true)
+    return dilate_convex_polyhedron(this->get_oshell()->get_cgal_polyhedron(), r);
+  return dilate_nef_polyhedron(*(this->get_nef_polyhedron()), r);
+}
+
+
+//-- the Nef of each shell is built once (via an EPEC polyhedron), and it is shared
+//-- by the validation of the Solid and the checks between the primitives
+Nef_polyhedron* Solid::get_nef_shell(int i)
+{
+  if (_shellnefs.size() != _shells.size())
+    _shellnefs.resize(_shells.size(), NULL);
+  if (_shellnefs[i] == NULL)
   {
     //-- convert to an EPEC Polyhedron so that convertion to Nef is possible
     CgalPolyhedronE pe;
-    Polyhedron_convert polyhedron_converter(*(sh->get_cgal_polyhedron()));
+    Polyhedron_convert polyhedron_converter(*(_shells[i]->get_cgal_polyhedron()));
     pe.delegate(polyhedron_converter);
-    Nef_polyhedron onef(pe);
-    nefs.push_back(onef);
+    _shellnefs[i] = new Nef_polyhedron(pe);
   }
-  Nef_polyhedron* re = new Nef_polyhedron;
-  *re += nefs[0];
-  for (int i = 1; i < nefs.size(); i++) 
-  {
-    *re -= nefs[i];
-  }
-  _nef = re;
-  return re;
+  return _shellnefs[i];
+}
+
+
+//-- frees the Nef polyhedra (they are built again if needed)
+void Solid::release_nef_polyhedra()
+{
+  delete _nef;
+  _nef = NULL;
+  for (auto& each : _shellnefs)
+    delete each;
+  _shellnefs.clear();
 }
 
 
@@ -318,22 +392,68 @@ bool Solid::validate_solid_with_nef()
     return true;
     
   // std::clog << "---Inspection interactions between the " << (this->num_ishells() + 1) << " shells" << std::endl;
-  std::vector<Nef_polyhedron> nefs;
-  for (auto& sh : this->get_shells())
+  const std::vector<Surface*>& shells = this->get_shells();
+  int nosh = static_cast<int>(shells.size());
+  //-- prefilter, without Nef: (1) an inner shell whose boundary doesn't touch that of
+  //-- the outer shell, and with one vertex inside it, fulfills axiom #1; (2) 2 inner 
+  //-- shells whose boundaries don't touch and that are not one inside the other 
+  //-- fulfill axiom #2. If all the shells are decided, then axiom #3 is fulfilled too.
+  //-- Otherwise the Nef polyhedra decide (only for the tests not decided).
+  typedef CGAL::Side_of_triangle_mesh<CgalPolyhedron, K> Side_of_shell;
+  std::vector<CGAL::Bbox_3> bboxes;
+  for (auto& sh : shells)
+    bboxes.push_back(CGAL::Polygon_mesh_processing::bbox(*(sh->get_cgal_polyhedron())));
+  std::vector<std::unique_ptr<Side_of_shell>> sides(nosh);
+  auto side_of_shell = [&](int s, const Point3& p) {
+    if (sides[s] == nullptr)
+      sides[s].reset(new Side_of_shell(*(shells[s]->get_cgal_polyhedron())));
+    return (*sides[s])(p);
+  };
+  auto a_vertex = [&](int s) {
+    return shells[s]->get_cgal_polyhedron()->vertices_begin()->point();
+  };
+  bool alldecided = true;
+  std::vector<bool> decided1(nosh, false);
+  for (int i = 1; i < nosh; i++)
   {
-    //-- convert to an EPEC Polyhedron so that convertion to Nef is possible
-    CgalPolyhedronE pe;
-    Polyhedron_convert polyhedron_converter(*(sh->get_cgal_polyhedron()));
-    pe.delegate(polyhedron_converter);
-    Nef_polyhedron onef(pe);
-    nefs.push_back(onef);
+    if ( (bboxes[i].xmin() >= bboxes[0].xmin()) && (bboxes[i].xmax() <= bboxes[0].xmax()) &&
+         (bboxes[i].ymin() >= bboxes[0].ymin()) && (bboxes[i].ymax() <= bboxes[0].ymax()) &&
+         (bboxes[i].zmin() >= bboxes[0].zmin()) && (bboxes[i].zmax() <= bboxes[0].zmax()) &&
+         (CGAL::Polygon_mesh_processing::do_intersect(*(shells[0]->get_cgal_polyhedron()), *(shells[i]->get_cgal_polyhedron())) == false) &&
+         (side_of_shell(0, a_vertex(i)) == CGAL::ON_BOUNDED_SIDE) )
+      decided1[i] = true;
+    else
+      alldecided = false;
+  }
+  std::vector<bool> decided2(nosh * nosh, false);
+  for (int i = 1; i < nosh; i++) 
+  {
+    for (int j = (i + 1); j < nosh; j++) 
+    {
+      if ( (CGAL::do_overlap(bboxes[i], bboxes[j]) == false) ||
+           ( (CGAL::Polygon_mesh_processing::do_intersect(*(shells[i]->get_cgal_polyhedron()), *(shells[j]->get_cgal_polyhedron())) == false) &&
+             (side_of_shell(j, a_vertex(i)) == CGAL::ON_UNBOUNDED_SIDE) &&
+             (side_of_shell(i, a_vertex(j)) == CGAL::ON_UNBOUNDED_SIDE) ) )
+        decided2[i * nosh + j] = true;
+      else
+        alldecided = false;
+    }
   }
+  if (alldecided == true)
+    return true;
+
+  //-- (copies of a Nef share its representation, they are cheap)
+  std::vector<Nef_polyhedron> nefs;
+  for (int i = 0; i < nosh; i++)
+    nefs.push_back(*(this->get_nef_shell(i)));
 
   //-- test axiom #1 from the paper, Sect 4.5:
   //-- https://3d.bk.tudelft.nl/hledoux/pdfs/13_cacaie.pdf
   Nef_polyhedron nef;
   for (int i = 1; i < nefs.size(); i++) 
   {
+    if (decided1[i] == true)
+      continue;
     nef = !nefs[0] * nefs[i];
     if (nef.is_empty() == false)
     {
@@ -387,6 +507,8 @@ bool Solid::validate_solid_with_nef()
   {
     for (int j = (i + 1); j < nefs.size(); j++) 
     {
+      if (decided2[i * nosh + j] == true)
+        continue;
       //-- 1. are they the same?
       if (nefs[i] == nefs[j])
       {
@@ -60,6 +60,11 @@ public:
  
   bool            validate(double tol_planarity_d2p, double tol_planarity_normals, double tol_overlap = -1);
   Nef_polyhedron* get_nef_polyhedron();
+  Nef_polyhedron* get_nef_shell(int i);
+  Nef_polyhedron  get_eroded_nef_polyhedron(float r);
+  Nef_polyhedron  get_dilated_nef_polyhedron(float r);
+  bool            is_convex();
+  void            release_nef_polyhedra();
   void            get_min_bbox(double& x, double& y);
   void            translate_vertices();
   std::string     get_poly_representation();
@@ -79,6 +84,8 @@ public:
 protected:
   std::vector<Surface*>  _shells;
   Nef_polyhedron*        _nef;
+  std::vector<Nef_polyhedron*>  _shellnefs; //-- one per shell, built only when needed
+  int                    _convex; //-- -1: not computed yet
 
   bool validate_solid_with_nef();
 };
@@ -31,10 +31,17 @@
 #include "geomtools.h"
 #include "input.h"
 #include "validate_shell.h"
+#include "validate_polygon2d.h"
 #include <CGAL/Polygon_mesh_processing/self_intersections.h>
 #include <CGAL/Side_of_triangle_mesh.h>
+#ifdef CGAL_LINKED_WITH_TBB
+  #include <tbb/task_arena.h>
+#endif
 #include <geos_c.h>
 #include <sstream>
+#include <cmath>
+#include <numeric>
+#include <unordered_set>
 
 using namespace std;
 
@@ -45,6 +52,8 @@ namespace val3dity
 
 double Surface::_shiftx = 0.0;
 double Surface::_shifty = 0.0;
+bool   Surface::_geos2d = false;
+int    Surface::_si_threads = 0;
 
 Surface::Surface(std::string id, double tol_snap)
 {
@@ -52,6 +61,7 @@ Surface::Surface(std::string id, double tol_snap)
   _is_valid_2d = -1;
   _vertices_added = 0;
   _tol_snap = tol_snap;
+  _polyhedron = NULL;
 }
 
 Surface::~Surface()
@@ -153,39 +163,34 @@ std::string Surface::get_off_representation()
 {
   std::stringstream ss;
   ss << "OFF" << std::endl;
-  int notr = 0;
-  for (auto& f: _lsTr) 
-    for (auto& t: f) 
-      notr++;
-  ss << _lsPts.size() << " " << notr << " 0" << std::endl;
+  ss << _lsPts.size() << " " << _lsTr.number_triangles() << " 0" << std::endl;
   //-- points
   for (auto& p : _lsPts)
     ss << setprecision(15) << p.x() << " " << p.y() << " " << p.z() << std::endl;
   //-- triangles
-  for (auto& f: _lsTr)
-  {
-    for (auto& t: f) 
-    {
-      ss << "3 " << t[0] << " " << t[1] << " " << t[2] << std::endl;
-    }
-  }
+  for (auto& t: _lsTr.tris)
+    ss << "3 " << t[0] << " " << t[1] << " " << t[2] << std::endl;
   return ss.str();
 }
 
 
-std::string Surface::get_coords_key(Point3* p)
+std::size_t Surface::CellKeyHash::operator()(const std::array<int64, 3>& k) const
 {
-  std::string s;
-  if (_tol_snap < 0.0)
-  {
-    s = std::to_string(p->x()) + std::to_string(p->y()) + std::to_string(p->z());
-  }
-  else
-  {
-    int tol = int(1 / _tol_snap);
-    s = std::to_string(int64(p->x() * tol)) + " " + std::to_string(int64(p->y() * tol)) + " " + std::to_string(int64(p->z() * tol));
-  }
-  return s;
+  std::size_t h = std::hash<int64>()(k[0]);
+  h ^= std::hash<int64>()(k[1]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  h ^= std::hash<int64>()(k[2]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
+
+std::array<int64, 3> Surface::get_cell_key(const Point3& p)
+{
+  double size = std::abs(_tol_snap);
+  std::array<int64, 3> k;
+  k[0] = int64(std::floor(p.x() / size));
+  k[1] = int64(std::floor(p.y() / size));
+  k[2] = int64(std::floor(p.z() / size));
+  return k;
 }
 
 bool Surface::were_vertices_merged_during_parsing()
@@ -206,16 +211,42 @@ int Surface::get_number_parsed_vertices()
 int Surface::add_point(Point3 pi)
 {
   _vertices_added += 1;
-  int i = 0;
-  for (auto& p : _lsPts)
+  //-- no snapping possible, a point is never closer than 0.0 to another one
+  if (_tol_snap == 0.0)
+  {
+    _lsPts.push_back(pi);
+    return (_lsPts.size() - 1);
+  }
+  //-- a point closer than _tol_snap is necessarily in one of the 27 neighbouring cells;
+  //-- the smallest index is kept so that the same vertices are merged as with a linear scan
+  std::array<int64, 3> k = get_cell_key(pi);
+  int re = -1;
+  for (int64 dx = -1; dx <= 1; dx++)
   {
-    auto d = CGAL::squared_distance(pi, p);
-    if (d < (_tol_snap*_tol_snap)) {
-      return i;
+    for (int64 dy = -1; dy <= 1; dy++)
+    {
+      for (int64 dz = -1; dz <= 1; dz++)
+      {
+        auto it = _snapgrid.find({k[0] + dx, k[1] + dy, k[2] + dz});
+        if (it == _snapgrid.end())
+          continue;
+        for (auto i : it->second)
+        {
+          if ( (re != -1) && (i > re) )
+            break;
+          if (CGAL::squared_distance(pi, _lsPts[i]) < (_tol_snap*_tol_snap))
+          {
+            re = i;
+            break;
+          }
+        }
+      }
     }
-    i++;
   }
+  if (re != -1)
+    return re;
   _lsPts.push_back(pi);
+  _snapgrid[k].push_back(_lsPts.size() - 1);
   return (_lsPts.size() - 1);
 }
 
@@ -246,6 +277,8 @@ bool Surface::triangulate_shell()
   // std::clog << "-----Triangulation of each surface" << std::endl;
   //-- read the facets
   size_t num = _lsFaces.size();
+  _lsTr.offsets.reserve(num + 1);
+  _lsTr.tris.reserve(2 * _lsPts.size());
   for (int i = 0; i < static_cast<int>(num); i++)
   {
     // These are the number of rings on this facet
@@ -253,91 +286,78 @@ bool Surface::triangulate_shell()
     std::vector<int> &idsob = _lsFaces[i][0]; // helpful alias for the outer boundary
     if ( (numf == 1) && (idsob.size() == 3)) 
     {
-      std::vector<int*> oneface;
-      int* tr = new int[3];
-      tr[0] = idsob[0] ;
-      tr[1] = idsob[1];
-      tr[2] = idsob[2];
-      oneface.push_back(tr);
-      _lsTr.push_back(oneface);
+      _lsTr.tris.push_back({idsob[0], idsob[1], idsob[2]});
+      _lsTr.close_face();
       continue;
     }
     //-- get projected CT
-    std::vector<int*> tris = construct_ct_one_face(_lsFaces[i]);
-    if (tris.size() == 0)
+    if (construct_ct_one_face(i) == false)
     {
       this->add_error(999, _lsFacesID[i], "face does not have an outer boundary.");
       return false;
     }
-    _lsTr.push_back(tris);
+    _lsTr.close_face();
   }
   return true;
 }
 
 
-std::vector<int*> 
-Surface::construct_ct_one_face(const std::vector<std::vector<int>>& pgnids)
+bool Surface::construct_ct_one_face(int i)
 {
-  std::vector<int*> re;
-
-  std::vector<Point3> planepts;
-  for (auto& each : pgnids[0]) {
-    planepts.push_back(_lsPts[each]);
-  }
-  Plane bestfitplane = get_best_fitted_plane(planepts);
-  //-- check orientation (for good normals for the output, pointing outwards)
-  bool reversed = false;
-  Polygon pgn;
-  for (auto& each : pgnids[0]) {
-    Point3 p = _lsPts[each];
-    pgn.push_back(bestfitplane.to_2d(p));
-  }
-  //-- check orientation, this works all must be ccw
-  if (pgn.is_counterclockwise_oriented() == false) {
-    reversed = true;
+  const std::vector<std::vector<int>>& pgnids = _lsFaces[i];
+  //-- the projected points and the orientation come from validate_2d_primitives()
+  const Point2* pts2d = &_face2d[_face2dstart[i]];
+  bool reversed = (_faceReversed[i] == 1);
+  //-- fast path: a strictly convex face without irings is triangulated directly, 
+  //-- the triangles have the orientation of the ring (like those of the CT below).
+  //-- For a quad the diagonal is the Delaunay one, like the CT would do.
+  if (pgnids.size() == 1) 
+  {
+    const std::vector<int>& ids = pgnids[0];
+    Polygon pgn(pts2d, pts2d + ids.size());
+    if (is_polygon_strictly_convex(pgn) == true)
+    {
+      int first = 0;
+      if ( (ids.size() == 4) && 
+           (CGAL::side_of_bounded_circle(pgn[0], pgn[1], pgn[2], pgn[3]) == CGAL::ON_BOUNDED_SIDE) )
+        first = 1;
+      for (std::size_t k = 1; k + 1 < ids.size(); k++)
+        _lsTr.tris.push_back({ids[first], ids[(first + k) % ids.size()], ids[(first + k + 1) % ids.size()]});
+      return true;
+    }
   }
   CT ct;
   for (auto& ring : pgnids) {
-    //-- make another *closed* ring for simplicity
-    std::vector<int> r2 = ring;
-    r2.push_back(ring.front());
-    std::vector<int>::const_iterator it;
-    std::vector<int>::iterator it2 = std::prev(r2.end());
-    for (it = r2.begin(); it != it2; it++) {
-      Point2 p0 = bestfitplane.to_2d(_lsPts[*it]);
-      CT::Vertex_handle v0 = ct.insert(p0);
-      v0->id() = *it;
-      auto it3 = it;
-      it3++;
-      Point2 p1 = bestfitplane.to_2d(_lsPts[*it3]);
-      CT::Vertex_handle v1 = ct.insert(p1);
-      v1->id() = *it3;
+    //-- the ring is closed with its first vertex
+    std::size_t n = ring.size();
+    for (std::size_t k = 0; k < n; k++) {
+      CT::Vertex_handle v0 = ct.insert(pts2d[k]);
+      v0->id() = ring[k];
+      std::size_t k1 = (k + 1) % n;
+      CT::Vertex_handle v1 = ct.insert(pts2d[k1]);
+      v1->id() = ring[k1];
       if (v0 != v1) {
         ct.insert_constraint(v0, v1);
       }
     }
+    pts2d += n;
   }
   mark_domains(ct); 
   if (!ct.is_valid()) 
-    return re;
+    return false;
+  std::size_t before = _lsTr.tris.size();
   for (CT::Finite_faces_iterator fit = ct.finite_faces_begin();
        fit != ct.finite_faces_end(); 
        ++fit) 
   {
     if (fit->info().in_domain()) {
-      int* tr = new int[3];
-      tr[0] = fit->vertex(0)->id();
-      if (reversed) {
-        tr[1] = fit->vertex(2)->id();
-        tr[2] = fit->vertex(1)->id();
-      } else {
-        tr[1] = fit->vertex(1)->id();
-        tr[2] = fit->vertex(2)->id();
-      }
-      re.push_back(tr);
+      if (reversed)
+        _lsTr.tris.push_back({fit->vertex(0)->id(), fit->vertex(2)->id(), fit->vertex(1)->id()});
+      else
+        _lsTr.tris.push_back({fit->vertex(0)->id(), fit->vertex(1)->id(), fit->vertex(2)->id()});
     }
   }
-  return re;
+  return (_lsTr.tris.size() > before);
 }
 
 
@@ -366,6 +386,13 @@ void Surface::translate_vertices()
     Point3 tp(CGAL::to_double(it->x() - Surface::_shiftx), CGAL::to_double(it->y() - Surface::_shifty), CGAL::to_double(it->z()));
     *it = tp;
   }
+  //-- the cells of the snapping grid have moved too
+  _snapgrid.clear();
+  if (_tol_snap != 0.0)
+  {
+    for (int i = 0; i < static_cast<int>(_lsPts.size()); i++)
+      _snapgrid[get_cell_key(_lsPts[i])].push_back(i);
+  }
 }
 
 
@@ -376,13 +403,29 @@ void Surface::set_translation_min_values(double minx, double miny)
 }
 
 
+void Surface::set_validation_2d_with_geos(bool geos)
+{
+  Surface::_geos2d = geos;
+}
+
+
+void Surface::set_self_intersection_threads(int threads)
+{
+  Surface::_si_threads = threads;
+}
+
+
 bool Surface::validate_2d_primitives(double tol_planarity_d2p, double tol_planarity_normals)
 {
   // std::clog << "-----2D validation of each surface" << std::endl;
   bool isValid = true;
   size_t num = _lsFaces.size();
+  _faceReversed.assign(num, 0);
+  _face2dstart.assign(num, 0);
+  _face2d.clear();
   for (int i = 0; i < static_cast<int>(num); i++)
   {
+    _face2dstart[i] = _face2d.size();
     //-- test for too few points (<3 for a ring)
     if (has_face_rings_toofewpoints(_lsFaces[i]) == true)
     {
@@ -436,33 +479,25 @@ bool Surface::validate_2d_primitives(double tol_planarity_d2p, double tol_planar
       isValid = false;
       continue;
     }
-    //-- get projected oring
-    Polygon pgn;
-    std::vector<Polygon> lsRings;
-    create_cgal_polygon(_lsPts, ids, bestfitplane, pgn);
-    if (validate_projected_ring(pgn, _lsFacesID[i]) == false)
+    //-- get projected rings, kept in the cache for the triangulation
+    std::vector<Polygon> lsRings(numf);
+    for (int j = 0; j < static_cast<int>(numf); j++)
     {
-      isValid = false;
-      continue;
-    }
-    lsRings.push_back(pgn);
-    //-- check for irings
-    for (int j = 1; j < static_cast<int>(numf); j++)
-    {
-      std::vector<int> &ids2 = _lsFaces[i][j]; // helpful alias for the inner boundary
-      //-- get projected iring
-      Polygon pgn;
-      create_cgal_polygon(_lsPts, ids2, bestfitplane, pgn);
-      if (validate_projected_ring(pgn, _lsFacesID[i]) == false)
+      for (auto& id : _lsFaces[i][j])
       {
-        isValid = false;
-        continue;
+        Point2 p = bestfitplane.to_2d(_lsPts[id]);
+        _face2d.push_back(p);
+        lsRings[j].push_back(p);
       }
-      lsRings.push_back(pgn);
     }
-    //-- use GEOS to validate projected polygon
-    if (!validate_polygon(lsRings, _lsFacesID[i]))
+    if (validate_projected_face(lsRings, _lsFacesID[i]) == false)
+    {
       isValid = false;
+      continue;
+    }
+    //-- all rings must be ccw for the CT, good normals for the output (pointing outwards)
+    if (lsRings[0].is_counterclockwise_oriented() == false)
+      _faceReversed[i] = 1;
   }
   if (isValid)
   {
@@ -470,26 +505,63 @@ bool Surface::validate_2d_primitives(double tol_planarity_d2p, double tol_planar
     triangulate_shell();
     //-- check planarity by normal deviation method (of all triangle)
     // std::clog << "-----Planarity of surfaces (with normals deviation)" << std::endl;
-    std::vector< std::vector<int*> >::iterator it = _lsTr.begin();
-    int j = 0;
     double deviation;
-    for ( ; it != _lsTr.end(); it++)
+    for (std::size_t j = 0; j < _lsTr.number_faces(); j++)
     { 
-      if (is_face_planar_normals(*it, _lsPts, deviation, tol_planarity_normals) == false)
+      if (is_face_planar_normals(_lsTr.face_begin(j), _lsTr.face_end(j), _lsPts, deviation, tol_planarity_normals) == false)
       {
         std::ostringstream msg;
         msg << "deviation normals: " << deviation << " (tolerance=" << tol_planarity_normals << ")";
         this->add_error(204, _lsFacesID[j], msg.str());
         isValid = false;
       }
-      j++;
     }
   }
+  //-- the cache is only needed for the triangulation
+  std::vector<Point2>().swap(_face2d);
+  std::vector<std::size_t>().swap(_face2dstart);
   _is_valid_2d = isValid;
   return isValid;
 }
 
 
+bool Surface::validate_projected_face(std::vector<Polygon>& lsRings, std::string faceid)
+{
+  size_t numf = lsRings.size();
+  //-- fast path: a strictly convex face without irings is valid
+  if ( (numf == 1) && (is_polygon_strictly_convex(lsRings[0]) == true) )
+    return true;
+  if (Surface::_geos2d == false)
+  {
+    //-- native validation of the projected polygon, all rings at once
+    std::vector<Polygon2DError> lsErrors;
+    if (validate_polygon_2d(lsRings, lsErrors) == true)
+      return true;
+    for (auto& e : lsErrors)
+      this->add_error(e.code, faceid, e.info);
+    return false;
+  }
+  //-- with GEOS: each ring is validated, then the polygon with GEOS
+  if (validate_projected_ring(lsRings[0], faceid) == false)
+    return false;
+  bool isValid = true;
+  std::vector<Polygon> lsValidRings;
+  lsValidRings.push_back(lsRings[0]);
+  for (int j = 1; j < static_cast<int>(numf); j++)
+  {
+    if (validate_projected_ring(lsRings[j], faceid) == false)
+    {
+      isValid = false;
+      continue;
+    }
+    lsValidRings.push_back(lsRings[j]);
+  }
+  if (!validate_polygon(lsValidRings, faceid))
+    isValid = false;
+  return isValid;
+}
+
+
 bool Surface::validate_as_multisurface(double tol_planarity_d2p, double tol_planarity_normals)
 {
   // std::clog << "--- MultiSurface validation ---" << std::endl;
@@ -601,10 +673,22 @@ bool Surface::contains_nonmanifold_vertices()
 
 bool Surface::does_self_intersect()
 {
-  if (CGAL::Polygon_mesh_processing::does_self_intersect(*_polyhedron) == true)
+  //-- one pass that collects the pairs of intersecting triangles, in parallel for
+  //-- large shells if CGAL is linked with TBB
+  std::vector<std::pair<CgalPolyhedron::Facet_const_handle, CgalPolyhedron::Facet_const_handle> > intersected_tris;
+#ifdef CGAL_LINKED_WITH_TBB
+  if ( (Surface::_si_threads != 1) && (_polyhedron->size_of_facets() >= 10000) )
   {
-    std::vector<std::pair<CgalPolyhedron::Facet_const_handle, CgalPolyhedron::Facet_const_handle> > intersected_tris;
+    tbb::task_arena arena( (Surface::_si_threads > 1) ? Surface::_si_threads : tbb::task_arena::automatic );
+    arena.execute([&] {
+      CGAL::Polygon_mesh_processing::self_intersections<CGAL::Parallel_tag>(*_polyhedron, std::back_inserter(intersected_tris));
+    });
+  }
+  else
+#endif
     CGAL::Polygon_mesh_processing::self_intersections(*_polyhedron, std::back_inserter(intersected_tris));
+  if (intersected_tris.empty() == false)
+  {
     std::set<CgalPolyhedron::Facet_const_handle> uniquetr;
     for (auto& each : intersected_tris)
     {
@@ -642,13 +726,16 @@ bool Surface::validate_as_shell(double tol_planarity_d2p, double tol_planarity_n
   if (_is_valid_2d == 0)
     return false;
 //-- 1. minimum number of faces = 4
-  if (_lsTr.size() < 4) 
+  if (_lsTr.number_faces() < 4) 
   {
     this->add_error(301);
     return false;
   }
 //-- 2. Combinatorial consistency
   // std::clog << "-----Combinatorial consistency" << std::endl;
+  int topo = check_edges_topology();
+  if (topo == 0)
+    return false;
   _polyhedron = construct_CgalPolyhedron_incremental(&(_lsTr), &(_lsPts), this);
   if (this->has_errors() == true)
     return false;
@@ -656,7 +743,11 @@ bool Surface::validate_as_shell(double tol_planarity_d2p, double tol_planarity_n
   {
     if (_polyhedron->is_valid() == true)
     {
-      if (_polyhedron->is_closed() == false)
+      if (topo == 1)
+      {
+        //-- closed and one connected component, nothing to probe
+      }
+      else if (_polyhedron->is_closed() == false)
       {
         _polyhedron->normalize_border();
         //-- check for unconnected faces
@@ -719,6 +810,189 @@ bool Surface::validate_as_shell(double tol_planarity_d2p, double tol_planarity_n
 }
 
 
+static int uf_find(std::vector<int>& parent, int x)
+{
+  while (parent[x] != x)
+  {
+    parent[x] = parent[parent[x]];
+    x = parent[x];
+  }
+  return x;
+}
+
+
+static inline uint64_t edge_key(int a, int b)
+{
+  return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+}
+
+
+//-- linear-time check of the combinatorial consistency of the shell, on the
+//-- triangles and before the polyhedron is built. Returns:
+//--   1: each edge is used by 2 triangles in opposite directions, all the vertices 
+//--      are manifold, and there is only one connected component
+//--   0: the shell is not valid (302/303/305/307 were reported)
+//--  -1: cannot tell (non-manifold vertices), the CGAL polyhedron must be built
+//--      and nothing is reported: test_facet() also looks at the fans of the 
+//--      vertices, the faces it rejects can then differ
+int Surface::check_edges_topology()
+{
+  const std::vector<TriangleIds>& tris = _lsTr.tris;
+  int notr = static_cast<int>(tris.size());
+  //-- 1. the directed edges are added triangle after triangle, like ConstructShell
+  //-- does: a triangle with an edge already used is flipped (307), if that's not 
+  //-- possible then >2 surfaces are incident to an edge (303)
+  std::unordered_map<uint64_t, int> halfedges;
+  halfedges.reserve(3 * tris.size());
+  std::vector<bool> added(notr, true);
+  std::vector<std::pair<int, std::size_t>> conflicts;
+  for (std::size_t f = 0; f < _lsTr.number_faces(); f++)
+  {
+    for (std::size_t t = _lsTr.offsets[f]; t < _lsTr.offsets[f + 1]; t++)
+    {
+      const TriangleIds& tr = tris[t];
+      bool used = false;
+      bool usedflipped = false;
+      for (int k = 0; k < 3; k++)
+      {
+        if (halfedges.count(edge_key(tr[k], tr[(k + 1) % 3])) > 0)
+          used = true;
+        if (halfedges.count(edge_key(tr[(k + 1) % 3], tr[k])) > 0)
+          usedflipped = true;
+      }
+      if (used == false)
+      {
+        for (int k = 0; k < 3; k++)
+          halfedges[edge_key(tr[k], tr[(k + 1) % 3])] = static_cast<int>(t);
+      }
+      else
+      {
+        added[t] = false;
+        conflicts.push_back(std::make_pair((usedflipped == false) ? 307 : 303, f));
+      }
+    }
+  }
+  //-- 2. the triangles sharing an edge are in the same component, and so are their 
+  //-- corners at the 2 vertices of the edge: a vertex is manifold if all its corners are.
+  //-- Only the triangles added above are used, the builder would keep the same ones
+  std::vector<int> comp(notr);
+  std::iota(comp.begin(), comp.end(), 0);
+  std::vector<int> corner(3 * notr);
+  std::iota(corner.begin(), corner.end(), 0);
+  std::vector<std::pair<int, int>> border;
+  for (int t = 0; t < notr; t++)
+  {
+    if (added[t] == false)
+      continue;
+    for (int k = 0; k < 3; k++)
+    {
+      int a = tris[t][k];
+      int b = tris[t][(k + 1) % 3];
+      auto it = halfedges.find(edge_key(b, a));
+      if (it == halfedges.end())
+      {
+        border.push_back(std::make_pair(a, b));
+        continue;
+      }
+      int t2 = it->second;
+      comp[uf_find(comp, t)] = uf_find(comp, t2);
+      for (int k2 = 0; k2 < 3; k2++)
+      {
+        if ( (tris[t2][k2] == a) || (tris[t2][k2] == b) )
+        {
+          int c = (tris[t2][k2] == a) ? k : (k + 1) % 3;
+          corner[uf_find(corner, 3 * t + c)] = uf_find(corner, 3 * t2 + k2);
+        }
+      }
+    }
+  }
+  std::vector<int> firstcorner(_lsPts.size(), -1);
+  for (int t = 0; t < notr; t++)
+  {
+    if (added[t] == false)
+      continue;
+    for (int k = 0; k < 3; k++)
+    {
+      int& fc = firstcorner[tris[t][k]];
+      if (fc == -1)
+        fc = 3 * t + k;
+      else if (uf_find(corner, fc) != uf_find(corner, 3 * t + k))
+        return -1;
+    }
+  }
+  if (conflicts.empty() == false)
+  {
+    //-- a rejected triangle at a vertex whose fan is closed (not on the border) can 
+    //-- be rejected by test_facet() because of that vertex, even when flipped
+    std::unordered_set<int> onborder;
+    for (auto& e : border)
+      onborder.insert(e.first);
+    for (int t = 0; t < notr; t++)
+    {
+      if (added[t] == true)
+        continue;
+      for (int k = 0; k < 3; k++)
+      {
+        int v = tris[t][k];
+        if ( (firstcorner[v] != -1) && (onborder.count(v) == 0) )
+          return -1;
+      }
+    }
+    for (auto& c : conflicts)
+      this->add_error(c.first, std::to_string(c.second));
+    return 0;
+  }
+  int nocomponents = 0;
+  for (int t = 0; t < notr; t++)
+    if (uf_find(comp, t) == t)
+      nocomponents++;
+  if (nocomponents > 1)
+  {
+    if (border.empty() == true)
+      this->add_error(305, "", "More than one connected components.");
+    else
+      this->add_error(305);
+    return 0;
+  }
+  if (border.empty() == true)
+    return 1;
+  //-- 3. the border edges form the holes, one loop each
+  std::unordered_map<int, int> next;
+  for (auto& e : border)
+    if (next.emplace(e.first, e.second).second == false)
+      return -1;
+  std::unordered_set<int> visited;
+  std::vector<int> holes;
+  for (auto& e : border)
+  {
+    if (visited.count(e.first) > 0)
+      continue;
+    holes.push_back(e.first);
+    int v = e.first;
+    while (visited.insert(v).second == true)
+    {
+      auto it = next.find(v);
+      if (it == next.end())
+        return -1;
+      v = it->second;
+    }
+  }
+  for (auto& v : holes)
+  {
+    std::stringstream st;
+    st << "Location hole: (";
+    st << (_lsPts[v].x() + _shiftx);
+    st << ", ";
+    st << (_lsPts[v].y() + _shifty);
+    st << ", ";
+    st << _lsPts[v].z();
+    st << ")";
+    this->add_error(302, "", st.str());
+  }
+  return 0;
+}
+
+
 bool Surface::validate_projected_ring(Polygon &pgn, std::string id)
 {
   if ( (!pgn.is_simple()) || (pgn.orientation() == CGAL::COLLINEAR) )
@@ -730,10 +1004,59 @@ bool Surface::validate_projected_ring(Polygon &pgn, std::string id)
 }
 
 
+//-- one GEOS context per thread (the _r functions are thread-safe), created
+//-- the first time a thread needs it and destroyed when the thread ends
+struct GEOSContext 
+{
+  GEOSContextHandle_t h;
+  GEOSContext()  { h = GEOS_init_r(); }
+  ~GEOSContext() { GEOS_finish_r(h); }
+};
+
+static GEOSContextHandle_t get_geos_context()
+{
+  static thread_local GEOSContext ctx;
+  return ctx.h;
+}
+
+
+//-- closed GEOS LinearRing built directly from the vertices of the ring
+static GEOSGeometry* create_geos_ring(GEOSContextHandle_t ctx, const Polygon& ring, bool reverse)
+{
+  unsigned int n = static_cast<unsigned int>(ring.size());
+  GEOSCoordSequence* seq = GEOSCoordSeq_create_r(ctx, n + 1, 2);
+  for (unsigned int i = 0; i <= n; i++)
+  {
+    unsigned int k = (i == n) ? 0 : i;
+    if ( (reverse == true) && (k != 0) )
+      k = n - k;
+    GEOSCoordSeq_setX_r(ctx, seq, i, ring[k].x());
+    GEOSCoordSeq_setY_r(ctx, seq, i, ring[k].y());
+  }
+  return GEOSGeom_createLinearRing_r(ctx, seq);
+}
+
+
+//-- error of val3dity for the reasons of GEOS (TopologyValidationError messages)
+static int geos_reason_to_error(const std::string& reason)
+{
+  static const std::map<std::string, int> codes = {
+    {"Self-intersection",        201},
+    {"Ring Self-intersection",   201},
+    {"Duplicate Rings",          202},
+    {"Interior is disconnected", 205},
+    {"Hole lies outside shell",  206},
+    {"Holes are nested",         207}
+  };
+  auto it = codes.find(reason);
+  if (it == codes.end())
+    return 999;
+  return it->second;
+}
+
+
 bool Surface::validate_polygon(std::vector<Polygon> &lsRings, std::string polygonid)
 {
-  // Use the _r geos functions to make it thread-safe
-  auto geos_ctx = GEOS_init_r();
   //-- check the orientation of the rings: oring != irings
   //-- we don't care about CCW or CW at this point, just opposite is important
   //-- GEOS doesn't do its job, so we have to do it here. Shame on you GEOS.
@@ -756,59 +1079,36 @@ bool Surface::validate_polygon(std::vector<Polygon> &lsRings, std::string polygo
   if (isvalid == false)
     return isvalid;
   //-- check 2D validity of the surface by (1) projecting them; (2) use GEOS IsValid()
-  stringstream wkt;
-  wkt << setprecision(15);
-  wkt << "POLYGON(";
-  std::vector<Polygon>::iterator it = lsRings.begin();
-  //-- oring
-  wkt << "(";
-  Polygon::Vertex_iterator vit = it->vertices_begin();
-  for ( ; vit != it->vertices_end(); vit++)
-  {
-    wkt << vit->x() << " " << vit->y() << ",";
-  }
-  vit = it->vertices_begin();
-  wkt << vit->x() << " " << vit->y() << ")";
-  it++;
-  //-- irings
-  for ( ; it != lsRings.end(); it++)
-  {
-    wkt << ", (";
-    it->reverse_orientation();
-    Polygon::Vertex_iterator vit = it->vertices_begin();
-    for ( ; vit != it->vertices_end(); vit++)
-    {
-      wkt << vit->x() << " " << vit->y() << ",";
-    }
-    vit = it->vertices_begin();
-    wkt << vit->x() << " " << vit->y() << ")";
-    it->reverse_orientation();
-  }
-  wkt << ")";
-  GEOSWKTReader* r;
-  r = GEOSWKTReader_create_r(geos_ctx);
-  GEOSGeometry* mygeom;
-  mygeom = GEOSWKTReader_read_r(geos_ctx, r, wkt.str().c_str());
-  string reason = (string)GEOSisValidReason_r(geos_ctx, mygeom);
-  if (reason.find("Valid Geometry") == string::npos)
+  //-- the GEOS geometry is built directly from the coordinates (no WKT), irings reversed
+  GEOSContextHandle_t ctx = get_geos_context();
+  GEOSGeometry* shell = create_geos_ring(ctx, lsRings[0], false);
+  std::vector<GEOSGeometry*> holes;
+  for (std::size_t i = 1; i < lsRings.size(); i++)
+    holes.push_back(create_geos_ring(ctx, lsRings[i], true));
+  GEOSGeometry* mygeom = GEOSGeom_createPolygon_r(ctx, shell, holes.data(), static_cast<unsigned int>(holes.size()));
+  char* reason = NULL;
+  GEOSGeometry* location = NULL;
+  char re = GEOSisValidDetail_r(ctx, mygeom, 0, &reason, &location);
+  if (re != 1)
   {
     isvalid = false;
-    if (reason.find("Self-intersection") != string::npos)
-      this->add_error(201, polygonid, reason.c_str());
-    else if (reason.find("Duplicate Rings") != string::npos)
-      this->add_error(202, polygonid, reason.c_str());
-    else if (reason.find("Interior is disconnected") != string::npos)
-      this->add_error(205, polygonid, reason.c_str());
-    else if (reason.find("Hole lies outside shell") != string::npos)
-      this->add_error(206, polygonid, reason.c_str());
-    else if (reason.find("Holes are nested") != string::npos)
-      this->add_error(207, polygonid, reason.c_str());
-    else
-      this->add_error(999, polygonid, reason.c_str());
+    std::string sreason = (reason != NULL) ? reason : "GEOS exception";
+    std::stringstream info;
+    info << sreason;
+    if (location != NULL)
+    {
+      double x, y;
+      GEOSGeomGetX_r(ctx, location, &x);
+      GEOSGeomGetY_r(ctx, location, &y);
+      info << setprecision(15) << "[" << x << " " << y << "]";
+    }
+    this->add_error(geos_reason_to_error(sreason), polygonid, info.str());
   }
-  GEOSWKTReader_destroy_r(geos_ctx, r);
-  GEOSGeom_destroy_r(geos_ctx, mygeom );
-  GEOS_finish_r(geos_ctx);
+  if (reason != NULL)
+    GEOSFree_r(ctx, reason);
+  if (location != NULL)
+    GEOSGeom_destroy_r(ctx, location);
+  GEOSGeom_destroy_r(ctx, mygeom);
   return isvalid;
 }
 
@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <array>
 #include <unordered_map>
 
 using json = nlohmann::json;
@@ -72,6 +73,8 @@ public:
   std::set<int> get_unique_error_codes();
   void          translate_vertices();
   static void   set_translation_min_values(double minx, double miny);
+  static void   set_validation_2d_with_geos(bool geos);
+  static void   set_self_intersection_threads(int threads);
   std::string   get_poly_representation();
   std::string   get_off_representation();
 
@@ -85,25 +88,42 @@ private:
   std::vector<Point3>                         _lsPts;
   std::vector<std::vector<std::vector<int>>>  _lsFaces;
   std::vector<std::string>                    _lsFacesID;
-  std::vector<std::vector<int*>>              _lsTr;
+  TriangulatedFaces                           _lsTr;
   CgalPolyhedron*                             _polyhedron;
   double                                      _tol_snap;
   int                                         _is_valid_2d; //-1: not done yet; 0: nope; 1: yes it's valid
   int                                         _vertices_added;
   static double                               _shiftx;
   static double                               _shifty;
+  static bool                                 _geos2d; //-- GEOS instead of the native 2D validation
+  static int                                  _si_threads; //-- for the self-intersections (0: all cores)
+
+  //-- per face (structure of arrays), filled by validate_2d_primitives() and reused 
+  //-- by the triangulation: orientation of the outer ring projected on the fitted plane,
+  //-- and projected points of all the rings (those of face i start at _face2d[_face2dstart[i]])
+  std::vector<char>                           _faceReversed;
+  std::vector<Point2>                         _face2d;
+  std::vector<std::size_t>                    _face2dstart;
+
+  //-- grid of cells of size _tol_snap, to find the points to snap to without a linear scan
+  struct CellKeyHash {
+    std::size_t operator()(const std::array<int64, 3>& k) const;
+  };
+  std::unordered_map<std::array<int64, 3>, std::vector<int>, CellKeyHash> _snapgrid;
 
   std::map<int, std::vector<std::tuple<std::string, std::string> > > _errors;
   
   bool validate_2d_primitives(double tol_planarity_d2p, double tol_planarity_normals);
-  std::string get_coords_key(Point3* p);
+  std::array<int64, 3> get_cell_key(const Point3& p);
   bool triangulate_shell();
-  std::vector<int*> construct_ct_one_face(const std::vector<std::vector<int>>& pgnids);
+  bool construct_ct_one_face(int i);
+  bool validate_projected_face(std::vector<Polygon>& lsRings, std::string faceid);
   bool validate_polygon(std::vector<Polygon> &lsRings, std::string polygonid);
   bool validate_projected_ring(Polygon &pgn, std::string id);
   bool has_face_rings_toofewpoints(const std::vector< std::vector<int> >& theface);
   bool has_face_2_consecutive_repeated_pts(const std::vector< std::vector<int> >& theface);
   bool contains_nonmanifold_vertices();
+  int  check_edges_topology();
 
 };
 
@@ -46,6 +46,8 @@
 #include <CGAL/Aff_transformation_3.h>
 
 #include <string>
+#include <vector>
+#include <array>
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
@@ -95,6 +97,22 @@ typedef CGAL::Polyhedron_copy_3<CgalPolyhedron, CgalPolyhedronE::HalfedgeDS> Pol
 
 typedef long long int64;
 
+//-- the triangles of all the faces of a surface in one contiguous buffer (CSR layout):
+//-- those of face i are [tris[offsets[i]], tris[offsets[i+1]])
+typedef std::array<int, 3>          TriangleIds;
+struct TriangulatedFaces
+{
+  std::vector<TriangleIds>  tris;
+  std::vector<std::size_t>  offsets{0};
+
+  std::size_t number_faces() const { return offsets.size() - 1; }
+  std::size_t number_triangles() const { return tris.size(); }
+  const TriangleIds* face_begin(std::size_t i) const { return tris.data() + offsets[i]; }
+  const TriangleIds* face_end(std::size_t i) const { return tris.data() + offsets[i + 1]; }
+  //-- the triangles added since the last call form one face
+  void close_face() { offsets.push_back(tris.size()); }
+};
+
 typedef enum
 {
   SOLID             = 0,
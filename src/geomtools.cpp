@@ -32,6 +32,9 @@
 #include <CGAL/minkowski_sum_3.h>
 #include <CGAL/OFF_to_nef_3.h>
 #include <CGAL/Bbox_3.h>
+#include <CGAL/convex_hull_3.h>
+#include <map>
+#include <algorithm>
 
 namespace val3dity
 {
@@ -85,8 +88,45 @@ void mark_domains(CT& ct) {
   }
 }  
 
-Nef_polyhedron* get_structuring_element_dodecahedron(float r)
+//-- the convex hull of points (exact), empty if they are all coplanar
+static Nef_polyhedron get_nef_convex_hull(std::vector<Point3E> pts)
 {
+  //-- a point can be given several times (eg where 4+ planes meet in the erosion)
+  std::sort(pts.begin(), pts.end());
+  pts.erase(std::unique(pts.begin(), pts.end()), pts.end());
+  //-- 3D if there are 3 non-collinear points and a 4th one not on their plane
+  std::size_t i = 2;
+  while ( (i < pts.size()) && (CGAL::collinear(pts[0], pts[1], pts[i]) == true) )
+    i++;
+  bool is3d = false;
+  for (std::size_t j = i + 1; (j < pts.size()) && (is3d == false); j++)
+    is3d = (CGAL::coplanar(pts[0], pts[1], pts[i], pts[j]) == false);
+  if (is3d == false)
+    return Nef_polyhedron(Nef_polyhedron::EMPTY);
+  CgalPolyhedronE hull;
+  CGAL::convex_hull_3(pts.begin(), pts.end(), hull);
+  return Nef_polyhedron(hull);
+}
+
+
+//-- the Nef of a box, built from its 8 vertices (no OFF to write and parse)
+static Nef_polyhedron get_nef_box(const KE::Iso_cuboid_3& box)
+{
+  std::vector<Point3E> pts;
+  for (int i = 0; i < 8; i++)
+    pts.push_back(box.vertex(i));
+  return get_nef_convex_hull(pts);
+}
+
+
+//-- the structuring elements are built once per size (and per thread, the Nefs are
+//-- not shared between the threads of '--jobs'), they are returned as handles
+Nef_polyhedron get_structuring_element_dodecahedron(float r)
+{
+  static thread_local std::map<float, Nef_polyhedron> cache;
+  auto it = cache.find(r);
+  if (it != cache.end())
+    return it->second;
   std::stringstream ss;
   ss << "OFF" << std::endl
     << "20 36 0"      << std::endl
@@ -146,77 +186,151 @@ Nef_polyhedron* get_structuring_element_dodecahedron(float r)
     << "3 12 0 10" << std::endl
     << "3 11 12 10" << std::endl
     << "3 18 11 10" << std::endl;
-  Nef_polyhedron* myse = new Nef_polyhedron;
-  CGAL::OFF_to_nef_3(ss, *myse);
+  Nef_polyhedron myse;
+  CGAL::OFF_to_nef_3(ss, myse);
   Transformation scale(CGAL::SCALING, r);
-  myse->transform(scale);
+  myse.transform(scale);
+  cache[r] = myse;
   return myse;
 }
 
-Nef_polyhedron* get_structuring_element_cube(float r)
+Nef_polyhedron get_structuring_element_cube(float r)
 {
-  std::stringstream ss;
-  ss << "OFF"        << std::endl
-     << "8 6 0"      << std::endl
-     << "1 1 1"      << std::endl
-     << "-1 1 1"     << std::endl
-     << "1 -1 1"     << std::endl
-     << "-1 -1 1"    << std::endl
-     << "1 1 -1 "    << std::endl
-     << "-1 1 -1"    << std::endl
-     << "1 -1 -1"    << std::endl
-     << "-1 -1 -1"   << std::endl
-     << "4 1 3 2 0"  << std::endl
-     << "4 2 6 4 0"  << std::endl
-     << "4 4 5 1 0"  << std::endl
-     << "4 5 4 6 7"  << std::endl
-     << "4 6 2 3 7"  << std::endl
-     << "4 3 1 5 7"  << std::endl;
-  Nef_polyhedron* mycube = new Nef_polyhedron;
-  CGAL::OFF_to_nef_3(ss, *mycube);
-  Transformation scale(CGAL::SCALING, r);
-  mycube->transform(scale);
+  static thread_local std::map<float, Nef_polyhedron> cache;
+  auto it = cache.find(r);
+  if (it != cache.end())
+    return it->second;
+  KE::FT tol(r);
+  Nef_polyhedron mycube = get_nef_box(KE::Iso_cuboid_3(-tol, -tol, -tol, tol, tol, tol));
+  cache[r] = mycube;
   return mycube;
 }
 
 
-Nef_polyhedron* dilate_nef_polyhedron(Nef_polyhedron* nef, float r)
+Nef_polyhedron dilate_nef_polyhedron(const Nef_polyhedron& nef, float r)
 {
-  Nef_polyhedron* output = new Nef_polyhedron;
-  Nef_polyhedron* cube = get_structuring_element_cube(r);
-  *output = CGAL::minkowski_sum_3(*nef, *cube);
-  return output;
+  Nef_polyhedron a = nef;
+  Nef_polyhedron cube = get_structuring_element_cube(r);
+  return CGAL::minkowski_sum_3(a, cube);
 }
 
 
-Nef_polyhedron* erode_nef_polyhedron(Nef_polyhedron* nef, float r)
+Nef_polyhedron erode_nef_polyhedron(const Nef_polyhedron& nef, float r)
 {
-  Nef_polyhedron* output = new Nef_polyhedron;
-  Nef_polyhedron* se = get_structuring_element_cube(r);
-  // Nef_polyhedron* se = get_structuring_element_dodecahedron(r);
-  Nef_polyhedron* bbox = get_aabb(nef);
-  Nef_polyhedron complement = *bbox - *nef;
-  Nef_polyhedron tmp = CGAL::minkowski_sum_3(complement, *se);
-  *output = *nef - tmp;
-  output->regularization();
-  // std::cout << "#volume " << output->number_of_volumes() << std::endl;
+  Nef_polyhedron se = get_structuring_element_cube(r);
+  // Nef_polyhedron se = get_structuring_element_dodecahedron(r);
+  Nef_polyhedron complement = get_aabb(nef) - nef;
+  Nef_polyhedron tmp = CGAL::minkowski_sum_3(complement, se);
+  Nef_polyhedron output = nef - tmp;
+  output.regularization();
+  // std::cout << "#volume " << output.number_of_volumes() << std::endl;
   // Nef_polyhedron::Vertex_const_iterator v;
-  // for (v = output->vertices_begin(); v != output->vertices_end(); v++)
+  // for (v = output.vertices_begin(); v != output.vertices_end(); v++)
   //   std::cout << v->point() << std::endl;
   return output;
 }
 
 
-Nef_polyhedron* get_aabb(Nef_polyhedron* mynef) 
+//-- the erosion of a convex polyhedron by the cube (half-size r) is the intersection of
+//-- the half-spaces of its faces, each moved inwards by the support of the cube along
+//-- its normal: its vertices are the intersections of 3 planes inside all the others. 
+//-- Returns false if the polyhedron has more than 'maxplanes' different planes
+bool erode_convex_polyhedron(CgalPolyhedron* poly, float r, int maxplanes, Nef_polyhedron& eroded)
+{
+  std::vector<PlaneE> planes;
+  for (auto f = poly->facets_begin(); f != poly->facets_end(); f++)
+  {
+    auto h = f->facet_begin();
+    Point3E p0(h->vertex()->point().x(), h->vertex()->point().y(), h->vertex()->point().z());
+    h++;
+    Point3E p1(h->vertex()->point().x(), h->vertex()->point().y(), h->vertex()->point().z());
+    h++;
+    Point3E p2(h->vertex()->point().x(), h->vertex()->point().y(), h->vertex()->point().z());
+    PlaneE pl(p0, p1, p2);
+    if (std::find(planes.begin(), planes.end(), pl) != planes.end())
+      continue;
+    planes.push_back(pl);
+    if (planes.size() > maxplanes)
+      return false;
+  }
+  //-- the interior is on the negative side: ax + by + cz + d <= 0
+  KE::FT tol(r);
+  for (auto& pl : planes)
+    pl = PlaneE(pl.a(), pl.b(), pl.c(), pl.d() + (tol * (CGAL::abs(pl.a()) + CGAL::abs(pl.b()) + CGAL::abs(pl.c()))));
+  std::vector<Point3E> pts;
+  for (std::size_t i = 0; i < planes.size(); i++)
+  {
+    for (std::size_t j = i + 1; j < planes.size(); j++)
+    {
+      for (std::size_t k = j + 1; k < planes.size(); k++)
+      {
+        const PlaneE& p = planes[i];
+        const PlaneE& q = planes[j];
+        const PlaneE& s = planes[k];
+        //-- Cramer's rule
+        KE::FT det = p.a() * (q.b() * s.c() - q.c() * s.b()) 
+                   - p.b() * (q.a() * s.c() - q.c() * s.a()) 
+                   + p.c() * (q.a() * s.b() - q.b() * s.a());
+        if (det == 0)
+          continue;
+        KE::FT x = (-p.d() * (q.b() * s.c() - q.c() * s.b()) 
+                    - p.b() * (-q.d() * s.c() + q.c() * s.d()) 
+                    + p.c() * (-q.d() * s.b() + q.b() * s.d())) / det;
+        KE::FT y = (p.a() * (-q.d() * s.c() + q.c() * s.d()) 
+                    + p.d() * (q.a() * s.c() - q.c() * s.a()) 
+                    + p.c() * (-q.a() * s.d() + q.d() * s.a())) / det;
+        KE::FT z = (p.a() * (-q.b() * s.d() + q.d() * s.b()) 
+                    - p.b() * (-q.a() * s.d() + q.d() * s.a()) 
+                    - p.d() * (q.a() * s.b() - q.b() * s.a())) / det;
+        Point3E pt(x, y, z);
+        bool inside = true;
+        for (auto& pl : planes)
+        {
+          if (pl.oriented_side(pt) == CGAL::ON_POSITIVE_SIDE)
+          {
+            inside = false;
+            break;
+          }
+        }
+        if (inside == true)
+          pts.push_back(pt);
+      }
+    }
+  }
+  eroded = get_nef_convex_hull(pts);
+  return true;
+}
+
+
+//-- the dilation of a convex polyhedron by the cube (half-size r) is the convex hull 
+//-- of its vertices moved to the 8 corners of the cube
+Nef_polyhedron dilate_convex_polyhedron(CgalPolyhedron* poly, float r)
+{
+  KE::FT tol(r);
+  std::vector<Point3E> pts;
+  for (auto v = poly->vertices_begin(); v != poly->vertices_end(); v++)
+  {
+    Point3E p(v->point().x(), v->point().y(), v->point().z());
+    for (int i = 0; i < 8; i++)
+      pts.push_back(Point3E(p.x() + (((i & 1) != 0) ? tol : -tol), 
+                            p.y() + (((i & 2) != 0) ? tol : -tol), 
+                            p.z() + (((i & 4) != 0) ? tol : -tol)));
+  }
+  return get_nef_convex_hull(pts);
+}
+
+
+//-- the bbox of a Nef, expanded by 10units
+Nef_polyhedron get_aabb(const Nef_polyhedron& mynef) 
 {
   double xmin =  1e12; 
   double ymin =  1e12; 
   double zmin =  1e12; 
   double xmax = -1e12;
   double ymax = -1e12;
-  double zmax = -1e12;;
+  double zmax = -1e12;
   Nef_polyhedron::Vertex_const_iterator v;
-  for (v = mynef->vertices_begin(); v != mynef->vertices_end(); v++) 
+  for (v = mynef.vertices_begin(); v != mynef.vertices_end(); v++) 
   {
     if ( CGAL::to_double(v->point().x()) < xmin )
       xmin = CGAL::to_double(v->point().x());
@@ -231,34 +345,7 @@ Nef_polyhedron* get_aabb(Nef_polyhedron* mynef)
     if ( CGAL::to_double(v->point().z()) > zmax )
       zmax = CGAL::to_double(v->point().z());
   }
-  //-- expand the bbox by 10units
-  xmin -= 10;
-  ymin -= 10;
-  zmin -= 10;
-  xmax += 10;
-  ymax += 10;
-  zmax += 10;
-  //-- write an OFF file and convert Nef, simplest (and fastest?) solution
-  std::stringstream ss;
-  ss << "OFF" << std::endl
-     << "8 6 0" << std::endl
-     << xmin << " " << ymin << " " << zmin << std::endl
-     << xmax << " " << ymin << " " << zmin << std::endl
-     << xmax << " " << ymax << " " << zmin << std::endl
-     << xmin << " " << ymax << " " << zmin << std::endl
-     << xmin << " " << ymin << " " << zmax << std::endl
-     << xmax << " " << ymin << " " << zmax << std::endl
-     << xmax << " " << ymax << " " << zmax << std::endl
-     << xmin << " " << ymax << " " << zmax << std::endl
-     << "4 0 3 2 1" << std::endl
-     << "4 0 1 5 4"    << std::endl
-     << "4 1 2 6 5"    << std::endl
-     << "4 2 3 7 6"    << std::endl
-     << "4 0 4 7 3"    << std::endl
-     << "4 4 5 6 7"    << std::endl;
-  Nef_polyhedron* nefbbox = new Nef_polyhedron;
-  CGAL::OFF_to_nef_3(ss, *nefbbox);
-  return nefbbox;
+  return get_nef_box(KE::Iso_cuboid_3(xmin - 10, ymin - 10, zmin - 10, xmax + 10, ymax + 10, zmax + 10));
 }
 
 
@@ -334,17 +421,51 @@ void create_cgal_polygon(const std::vector<Point3>& lsPts, const std::vector<int
 }
 
 
-bool is_face_planar_normals(const std::vector<int*> &trs, const std::vector<Point3>& lsPts, double& value, float angleTolerance)
+//-- strictly convex: all the turns have the same orientation (no collinear vertices)
+//-- and the ring turns only once around (its vertices change xy-direction only twice),
+//-- thus it is also simple and not collapsed to a line
+bool is_polygon_strictly_convex(const Polygon& pgn)
+{
+  std::size_t n = pgn.size();
+  if (n < 3)
+    return false;
+  CGAL::Orientation o0 = CGAL::COLLINEAR;
+  CGAL::Comparison_result prevdir = CGAL::compare_xy(pgn[n - 1], pgn[0]);
+  int changes = 0;
+  for (std::size_t i = 0; i < n; i++)
+  {
+    const Point2& a = pgn[(i + n - 1) % n];
+    const Point2& b = pgn[i];
+    const Point2& c = pgn[(i + 1) % n];
+    CGAL::Orientation o = CGAL::orientation(a, b, c);
+    if (o == CGAL::COLLINEAR)
+      return false;
+    if (o0 == CGAL::COLLINEAR)
+      o0 = o;
+    else if (o != o0)
+      return false;
+    CGAL::Comparison_result dir = CGAL::compare_xy(b, c);
+    if (dir == CGAL::EQUAL)
+      return false;
+    if (dir != prevdir)
+      changes++;
+    prevdir = dir;
+  }
+  return (changes == 2);
+}
+
+
+bool is_face_planar_normals(const TriangleIds* begin, const TriangleIds* end, const std::vector<Point3>& lsPts, double& value, float angleTolerance)
 {
-  std::vector<int*>::const_iterator ittr = trs.begin();
-  int* a = *ittr;
-  Vector v0 = unit_normal( lsPts[a[0]], lsPts[a[1]], lsPts[a[2]]);
+  const TriangleIds* ittr = begin;
+  const TriangleIds& t0 = *ittr;
+  Vector v0 = unit_normal( lsPts[t0[0]], lsPts[t0[1]], lsPts[t0[2]]);
   ittr++;
   bool isPlanar = true;
-  for ( ; ittr != trs.end(); ittr++)
+  for ( ; ittr != end; ittr++)
   {
-    a = *ittr;
-    Vector v1 = unit_normal( lsPts[a[0]], lsPts[a[1]], lsPts[a[2]] );
+    const TriangleIds& t = *ittr;
+    Vector v1 = unit_normal( lsPts[t[0]], lsPts[t[1]], lsPts[t[2]] );
     Vector a = CGAL::cross_product(v0, v1);
     K::FT norm = sqrt(a.squared_length());
     double dot = CGAL::to_double((v0*v1));
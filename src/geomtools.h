@@ -41,17 +41,20 @@ CgalPolyhedron::Plane_3  get_best_fitted_plane(const std::vector< Point3 > &lsPt
 
 bool    cmpPoint3(Point3 &p1, Point3 &p2, double tol);
 void    create_cgal_polygon(const std::vector<Point3>& lsPts, const std::vector<int>& ids, const CgalPolyhedron::Plane_3 &plane, Polygon &outpgn);
+bool    is_polygon_strictly_convex(const Polygon& pgn);
 bool    is_face_planar_distance2plane(const std::vector<Point3> &pts, const CgalPolyhedron::Plane_3 &plane, double& value, float tolerance);
-bool    is_face_planar_normals(const std::vector<int*> &trs, const std::vector<Point3>& lsPts, double& value, float angleTolerance);
+bool    is_face_planar_normals(const TriangleIds* begin, const TriangleIds* end, const std::vector<Point3>& lsPts, double& value, float angleTolerance);
 
 void mark_domains(CT& ct);
 void mark_domains(CT& ct, CT::Face_handle start, int index, std::list<CT::Edge>& border);
 
-Nef_polyhedron* dilate_nef_polyhedron(Nef_polyhedron* nef, float r);
-Nef_polyhedron* erode_nef_polyhedron (Nef_polyhedron* nef, float r);
-Nef_polyhedron* get_structuring_element_cube(float r);
-Nef_polyhedron* get_structuring_element_dodecahedron(float r);
-Nef_polyhedron* get_aabb(Nef_polyhedron* mynef) ;
+Nef_polyhedron dilate_nef_polyhedron(const Nef_polyhedron& nef, float r);
+Nef_polyhedron erode_nef_polyhedron (const Nef_polyhedron& nef, float r);
+Nef_polyhedron dilate_convex_polyhedron(CgalPolyhedron* poly, float r);
+bool           erode_convex_polyhedron (CgalPolyhedron* poly, float r, int maxplanes, Nef_polyhedron& eroded);
+Nef_polyhedron get_structuring_element_cube(float r);
+Nef_polyhedron get_structuring_element_dodecahedron(float r);
+Nef_polyhedron get_aabb(const Nef_polyhedron& mynef);
 
 } // namespace val3dity
 
@@ -40,7 +40,11 @@
 #include "CompositeSolid.h"
 #include "MultiSolid.h"
 #include "GeometryTemplate.h"
+#include "pipeline.h"
+#include "textinput.h"
 
+#include <functional>
+#include <memory>
 
 using namespace std;
 using json = nlohmann::json;
@@ -131,6 +135,78 @@ void IOErrors::set_input_file_type(std::string s) {
 
 
 
+void ValidationSummary::add_feature(Feature* f)
+{
+  _nofeatures++;
+  std::get<0>(_feat_o[f->get_type()]) += 1;
+  if (f->is_valid() == true) {
+    _nofeatures_valid++;
+    std::get<1>(_feat_o[f->get_type()]) += 1;
+  }
+  for (auto& code : f->get_unique_error_codes()) {
+    _errors.insert(code);
+    if (code > 600)
+      _errors_f[code] += 1;
+  }
+  for (auto& p : f->get_primitives()) {
+    _noprimitives++;
+    std::get<0>(_prim_o[p->get_type()]) += 1;
+    if (p->is_valid() == true) {
+      _noprimitives_valid++;
+      std::get<1>(_prim_o[p->get_type()]) += 1;
+    }
+    for (auto& code : p->get_unique_error_codes())
+      _errors_p[code] += 1;
+  }
+}
+
+
+int ValidationSummary::number_features() {
+  return _nofeatures;
+}
+
+
+int ValidationSummary::number_features_valid() {
+  return _nofeatures_valid;
+}
+
+
+int ValidationSummary::number_primitives() {
+  return _noprimitives;
+}
+
+
+int ValidationSummary::number_primitives_valid() {
+  return _noprimitives_valid;
+}
+
+
+std::map<std::string, std::tuple<int,int> >& ValidationSummary::get_features_overview() {
+  return _feat_o;
+}
+
+
+std::map<int, std::tuple<int,int> >& ValidationSummary::get_primitives_overview() {
+  return _prim_o;
+}
+
+
+std::map<int, int>& ValidationSummary::get_errors_features() {
+  return _errors_f;
+}
+
+
+std::map<int, int>& ValidationSummary::get_errors_primitives() {
+  return _errors_p;
+}
+
+
+std::set<int>& ValidationSummary::get_unique_error_codes() {
+  return _errors;
+}
+
+
+
 //-- ignore XML namespace
 std::string localise(std::string s)
 {
@@ -145,51 +221,39 @@ std::string remove_xml_namespace(const char* input)
 }
 
 
-vector<int> process_gml_ring(const pugi::xml_node& n, Surface* sh, IOErrors& errs) {
-  std::string s = "./" + NS["gml"] + "LinearRing" + "/" + NS["gml"] + "pos";
-  pugi::xpath_node_set npos = n.select_nodes(s.c_str());
+vector<int> process_gml_ring(const pugi::xml_node& n, Surface* sh, GMLIndex& gmlindex, IOErrors& errs) {
+  //-- the coordinates were parsed by build_gml_index()
+  std::string s = NS["gml"] + "LinearRing";
+  pugi::xml_node lr = n.child(s.c_str());
   std::vector<int> r;
-  if (npos.size() > 0) //-- <gml:pos> used
+  const double* c;
+  std::size_t size;
+  s = NS["gml"] + "pos";
+  if (lr.child(s.c_str())) //-- <gml:pos> used
   {
-    for (pugi::xpath_node_set::const_iterator it = npos.begin(); it != npos.end(); ++it) {
-      std::string buf;
-      std::stringstream ss(it->node().child_value());
-      std::vector<std::string> tokens;
-      while (ss >> buf)
-        tokens.push_back(buf);
-      long double x = std::stold(tokens[0]);
-      x -= _minx;
-      long double y = std::stold(tokens[1]);
-      y -= _miny;
-      Point3 p(double(x), double(y), std::stod(tokens[2]));
+    for (pugi::xml_node npos : lr.children(s.c_str())) {
+      if ( (gmlindex.get_coords(npos, c, size) == false) || (size < 3) )
+        throw 901;
+      Point3 p(c[0] - _minx, c[1] - _miny, c[2]);
       r.push_back(sh->add_point(p));
     }
   }
   else //-- <gml:posList> used
   {
-    std::string s = "./" + NS["gml"] + "LinearRing" + "/" + NS["gml"] + "posList";
-    pugi::xpath_node pl = n.select_node(s.c_str());
-    if (pl == NULL)
+    s = NS["gml"] + "posList";
+    pugi::xml_node pl = lr.child(s.c_str());
+    if (!pl)
     {
       throw 901;
     }
-    std::string buf;
-    std::stringstream ss(pl.node().child_value());
-    std::vector<std::string> coords;
-    while (ss >> buf)
-      coords.push_back(buf);
-    if (coords.size() % 3 != 0)
+    if ( (gmlindex.get_coords(pl, c, size) == false) || (size % 3 != 0) )
     {
       errs.add_error(901, "Error: <gml:posList> has bad coordinates.");
       return r;
     }
-    for (int i = 0; i < coords.size(); i += 3)
+    for (std::size_t i = 0; i < size; i += 3)
     {
-      long double x = std::stold(coords[i]);
-      x -= _minx;
-      long double y = std::stold(coords[i+1]);
-      y -= _miny;
-      Point3 p(double(x), double(y), std::stod(coords[i+2]));
+      Point3 p(c[i] - _minx, c[i + 1] - _miny, c[i + 2]);
       r.push_back(sh->add_point(p));
     }
   }
@@ -197,7 +261,7 @@ vector<int> process_gml_ring(const pugi::xml_node& n, Surface* sh, IOErrors& err
 }
 
 
-Surface* process_gml_surface(const pugi::xml_node& n, int id, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs) 
+Surface* process_gml_surface(const pugi::xml_node& n, int id, GMLIndex& gmlindex, double tol_snap, IOErrors& errs) 
 {
   std::string s = ".//" + NS["gml"] + "surfaceMember";
   pugi::xpath_node_set nsm = n.select_nodes(s.c_str());
@@ -222,7 +286,7 @@ Surface* process_gml_surface(const pugi::xml_node& n, int id, std::map<std::stri
       std::string k = it->node().attribute("xlink:href").value();
       if (k[0] == '#')
         k = k.substr(1);
-      p = dallpoly[k];
+      p = gmlindex.dallpoly[k];
     }
     else
     {
@@ -244,7 +308,7 @@ Surface* process_gml_surface(const pugi::xml_node& n, int id, std::map<std::stri
               {
                 if (k[0] == '#')
                   k = k.substr(1);
-                p = dallpoly[k];
+                p = gmlindex.dallpoly[k];
                 break;
               }
               for (pugi::xml_node child3 : child2.children())
@@ -276,7 +340,7 @@ Surface* process_gml_surface(const pugi::xml_node& n, int id, std::map<std::stri
     //-- exterior ring (only 1)
     s = ".//" + NS["gml"] + "exterior";
     pugi::xpath_node ring = p.node().select_node(s.c_str());
-    std::vector<int> r = process_gml_ring(ring.node(), sh, errs);
+    std::vector<int> r = process_gml_ring(ring.node(), sh, gmlindex, errs);
     if (fliporientation == true) 
       std::reverse(r.begin(), r.end());
     if (r.front() != r.back())
@@ -293,7 +357,7 @@ Surface* process_gml_surface(const pugi::xml_node& n, int id, std::map<std::stri
     s = ".//" + NS["gml"] + "interior";
     pugi::xpath_node_set nint = p.node().select_nodes(s.c_str());
     for (pugi::xpath_node_set::const_iterator it = nint.begin(); it != nint.end(); ++it) {
-      std::vector<int> r = process_gml_ring(it->node(), sh, errs);
+      std::vector<int> r = process_gml_ring(it->node(), sh, gmlindex, errs);
       if (fliporientation == true) 
         std::reverse(r.begin(), r.end());
       if (r.front() != r.back())
@@ -314,7 +378,7 @@ Surface* process_gml_surface(const pugi::xml_node& n, int id, std::map<std::stri
 }
 
 
-Solid* process_gml_solid(const pugi::xml_node& nsolid, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs)
+Solid* process_gml_solid(const pugi::xml_node& nsolid, GMLIndex& gmlindex, double tol_snap, IOErrors& errs)
 {
   //-- exterior shell
   Solid* sol = new Solid();
@@ -322,21 +386,21 @@ Solid* process_gml_solid(const pugi::xml_node& nsolid, std::map<std::string, pug
     sol->set_id(std::string(nsolid.attribute("gml:id").value()));
   std::string s = "./" + NS["gml"] + "exterior";
   pugi::xpath_node next = nsolid.select_node(s.c_str());
-  sol->set_oshell(process_gml_surface(next.node(), 0, dallpoly, tol_snap, errs));
+  sol->set_oshell(process_gml_surface(next.node(), 0, gmlindex, tol_snap, errs));
   //-- interior shells
   s = "./" + NS["gml"] + "interior";
   pugi::xpath_node_set nint = nsolid.select_nodes(s.c_str());
   int id = 1;
   for (pugi::xpath_node_set::const_iterator it = nint.begin(); it != nint.end(); ++it)
   {
-    sol->add_ishell(process_gml_surface(it->node(), id, dallpoly, tol_snap, errs));
+    sol->add_ishell(process_gml_surface(it->node(), id, gmlindex, tol_snap, errs));
     id++;
   }
   return sol;
 }
 
 
-MultiSolid* process_gml_multisolid(const pugi::xml_node& nms, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs)
+MultiSolid* process_gml_multisolid(const pugi::xml_node& nms, GMLIndex& gmlindex, double tol_snap, IOErrors& errs)
 {
   MultiSolid* ms = new MultiSolid();
   if (nms.attribute("gml:id") != 0)
@@ -345,7 +409,7 @@ MultiSolid* process_gml_multisolid(const pugi::xml_node& nms, std::map<std::stri
   pugi::xpath_node_set nn = nms.select_nodes(s.c_str());
   for (pugi::xpath_node_set::const_iterator it = nn.begin(); it != nn.end(); ++it)
   {
-    Solid* s = process_gml_solid(it->node(), dallpoly, tol_snap, errs);
+    Solid* s = process_gml_solid(it->node(), gmlindex, tol_snap, errs);
     if (s->get_id() == "")
       s->set_id(std::to_string(ms->number_of_solids()));
     ms->add_solid(s);
@@ -354,7 +418,7 @@ MultiSolid* process_gml_multisolid(const pugi::xml_node& nms, std::map<std::stri
 }
 
 
-CompositeSolid* process_gml_compositesolid(const pugi::xml_node& nms, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs)
+CompositeSolid* process_gml_compositesolid(const pugi::xml_node& nms, GMLIndex& gmlindex, double tol_snap, IOErrors& errs)
 {
   CompositeSolid* cs = new CompositeSolid();
   if (nms.attribute("gml:id") != 0)
@@ -363,7 +427,7 @@ CompositeSolid* process_gml_compositesolid(const pugi::xml_node& nms, std::map<s
   pugi::xpath_node_set nn = nms.select_nodes(s.c_str());
   for (pugi::xpath_node_set::const_iterator it = nn.begin(); it != nn.end(); ++it)
   {
-    Solid* s = process_gml_solid(it->node(), dallpoly, tol_snap, errs);
+    Solid* s = process_gml_solid(it->node(), gmlindex, tol_snap, errs);
     if (s->get_id() == "")
       s->set_id(std::to_string(cs->number_of_solids()));
     cs->add_solid(s);
@@ -373,29 +437,30 @@ CompositeSolid* process_gml_compositesolid(const pugi::xml_node& nms, std::map<s
 }
 
 
-MultiSurface* process_gml_multisurface(const pugi::xml_node& nms, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs)
+MultiSurface* process_gml_multisurface(const pugi::xml_node& nms, GMLIndex& gmlindex, double tol_snap, IOErrors& errs)
 {
   MultiSurface* ms = new MultiSurface();
   if (nms.attribute("gml:id") != 0)
     ms->set_id(std::string(nms.attribute("gml:id").value()));
-  Surface* s = process_gml_surface(nms, 0, dallpoly, tol_snap, errs);
+  Surface* s = process_gml_surface(nms, 0, gmlindex, tol_snap, errs);
   ms->set_surface(s);
   return ms;
 }
 
 
-CompositeSurface* process_gml_compositesurface(const pugi::xml_node& nms, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs)
+CompositeSurface* process_gml_compositesurface(const pugi::xml_node& nms, GMLIndex& gmlindex, double tol_snap, IOErrors& errs)
 {
   CompositeSurface* cs = new CompositeSurface();
   if (nms.attribute("gml:id") != 0)
     cs->set_id(std::string(nms.attribute("gml:id").value()));
-  Surface* s = process_gml_surface(nms, 0, dallpoly, tol_snap, errs);
+  Surface* s = process_gml_surface(nms, 0, gmlindex, tol_snap, errs);
   cs->set_surface(s);
   return cs;
 }
 
 
-void process_json_surface(std::vector< std::vector<int> >& pgn, json& j, Surface* sh)
+//-- vertices is a flat array (x0, y0, z0, x1, ...) with the transform already applied
+void process_json_surface(std::vector< std::vector<int> >& pgn, const std::vector<double>& vertices, Surface* sh)
 {
   std::vector< std::vector<int> > pgnids;
   for (auto& r : pgn)
@@ -403,23 +468,9 @@ void process_json_surface(std::vector< std::vector<int> >& pgn, json& j, Surface
     std::vector<int> newr;
     for (auto& i : r)
     {
-      double x;
-      double y;
-      double z;
-      if (j.count("transform") == 0)
-      {
-        x = double(j["vertices"][i][0]);
-        y = double(j["vertices"][i][1]);
-        z = double(j["vertices"][i][2]);
-      }
-      else
-      {
-        x = (double(j["vertices"][i][0]) * double(j["transform"]["scale"][0])) + double(j["transform"]["translate"][0]);
-        y = (double(j["vertices"][i][1]) * double(j["transform"]["scale"][1])) + double(j["transform"]["translate"][1]);
-        z = (double(j["vertices"][i][2]) * double(j["transform"]["scale"][2])) + double(j["transform"]["translate"][2]);
-      }
-      x -= _minx;
-      y -= _miny;
+      double x = vertices.at(3 * i) - _minx;
+      double y = vertices.at(3 * i + 1) - _miny;
+      double z = vertices.at(3 * i + 2);
       Point3 p3(x, y, z);
       newr.push_back(sh->add_point(p3));
     }
@@ -429,6 +480,59 @@ void process_json_surface(std::vector< std::vector<int> >& pgn, json& j, Surface
 }
 
 
+//-- decodes (and transforms) the "vertices" of j into a flat array (x0, y0, z0, x1, ...),
+//-- and in the same pass computes (_minx, _miny) if update_min_xy
+void decode_json_vertices(json& j, std::vector<double>& vertices, bool update_min_xy)
+{
+  double s[3] = {1.0, 1.0, 1.0};
+  double t[3] = {0.0, 0.0, 0.0};
+  if (j.count("transform") != 0)
+  {
+    for (int k = 0; k < 3; k++)
+    {
+      s[k] = double(j["transform"]["scale"][k]);
+      t[k] = double(j["transform"]["translate"][k]);
+    }
+  }
+  json& jv = j["vertices"];
+  vertices.resize(3 * jv.size());
+  double minx = _minx;
+  double miny = _miny;
+  std::size_t i = 0;
+  for (auto& v : jv)
+  {
+    for (int k = 0; k < 3; k++)
+      vertices[i + k] = (double(v[k]) * s[k]) + t[k];
+    if (vertices[i] < minx)
+      minx = vertices[i];
+    if (vertices[i + 1] < miny)
+      miny = vertices[i + 1];
+    i += 3;
+  }
+  if (update_min_xy == true)
+  {
+    _minx = minx;
+    _miny = miny;
+    Primitive::set_translation_min_values(_minx, _miny);
+    Surface::set_translation_min_values(_minx, _miny);
+  }
+}
+
+
+void apply_json_transform(std::vector<double>& vertices, json& jtransform)
+{
+  double s[3], t[3];
+  for (int k = 0; k < 3; k++)
+  {
+    s[k] = double(jtransform["scale"][k]);
+    t[k] = double(jtransform["translate"][k]);
+  }
+  for (std::size_t i = 0; i + 2 < vertices.size(); i += 3)
+    for (int k = 0; k < 3; k++)
+      vertices[i + k] = (vertices[i + k] * s[k]) + t[k];
+}
+
+
 void process_jsonfg_surface(std::vector<std::vector<std::vector<double>>>& pgn, Surface* sh, IOErrors& errs)
 {
   std::vector<std::vector<int>> pgnids;
@@ -452,7 +556,7 @@ void process_jsonfg_surface(std::vector<std::vector<std::vector<double>>>& pgn,
 }
 
 
-void process_json_geometries_of_co(json& jco, CityObject* co, std::string coid, std::vector<GeometryTemplate*>& lsGTs, json& j, double tol_snap)
+void process_json_geometries_of_co(json& jco, CityObject* co, std::string coid, std::vector<GeometryTemplate*>& lsGTs, const std::vector<double>& vertices, double tol_snap)
 {
   int idgeom = 0;
   for (auto& g : jco["geometry"]) {
@@ -475,7 +579,7 @@ void process_json_geometries_of_co(json& jco, CityObject* co, std::string coid,
         Surface* sh = new Surface(shid, tol_snap);
         for (auto& polygon : shell) { 
           std::vector< std::vector<int> > pa = polygon;
-          process_json_surface(pa, j, sh);
+          process_json_surface(pa, vertices, sh);
         }
         if (oshell == true)
         {
@@ -495,7 +599,7 @@ void process_json_geometries_of_co(json& jco, CityObject* co, std::string coid,
       for (auto& p : g["boundaries"]) 
       { 
         std::vector< std::vector<int> > pa = p;
-        process_json_surface(pa, j, sh);
+        process_json_surface(pa, vertices, sh);
       }
       std::string thelod = "";
       if (g["lod"].is_number()) {
@@ -541,7 +645,7 @@ void process_json_geometries_of_co(json& jco, CityObject* co, std::string coid,
           Surface* sh = new Surface(shid, tol_snap);
           for (auto& polygon : shell) { 
             std::vector< std::vector<int> > pa = polygon;
-            process_json_surface(pa, j, sh);
+            process_json_surface(pa, vertices, sh);
           }
           if (oshell == true)
           {
@@ -581,7 +685,7 @@ void process_json_geometries_of_co(json& jco, CityObject* co, std::string coid,
           Surface* sh = new Surface(shid, tol_snap);
           for (auto& polygon : shell) { 
             std::vector< std::vector<int> > pa = polygon;
-            process_json_surface(pa, j, sh);
+            process_json_surface(pa, vertices, sh);
           }
           if (oshell == true)
           {
@@ -608,7 +712,8 @@ void process_json_geometries_of_co(json& jco, CityObject* co, std::string coid,
   }
 }
 
-void read_file_json(std::string &ifile, std::vector<Feature*>& lsFeatures, IOErrors& errs, double tol_snap)
+//-- the GeometryTemplates are shared by the Features, they are owned by the caller (lsGTs)
+void read_file_json(std::string &ifile, std::vector<Feature*>& lsFeatures, std::vector<GeometryTemplate*>& lsGTs, IOErrors& errs, double tol_snap)
 {
   std::ifstream input(ifile);
   json j;
@@ -624,7 +729,7 @@ void read_file_json(std::string &ifile, std::vector<Feature*>& lsFeatures, IOErr
   // TODO: other validation for CityJSON or just let it crash?
   if (j["type"] == "CityJSON") {
     errs.set_input_file_type("CityJSON");
-    parse_cityjson(j, lsFeatures, tol_snap);
+    parse_cityjson(j, lsFeatures, lsGTs, tol_snap);
   } 
   else if (j["type"] == "tu3djson") {
     errs.set_input_file_type("tu3djson");
@@ -647,7 +752,7 @@ void read_file_json(std::string &ifile, std::vector<Feature*>& lsFeatures, IOErr
   }
 }
 
-void read_file_cjseq(std::string &ifile, std::vector<Feature*>& lsFeatures, IOErrors& errs, double tol_snap)
+void read_file_cjseq(std::string &ifile, std::vector<Feature*>& lsFeatures, std::vector<GeometryTemplate*>& lsGTs, IOErrors& errs, double tol_snap)
 {
   std::cout << "CityJSONSeq input file" << std::endl;
   std::ifstream infile(ifile.c_str(), std::ifstream::in);
@@ -656,8 +761,6 @@ void read_file_cjseq(std::string &ifile, std::vector<Feature*>& lsFeatures, IOEr
     errs.add_error(901, "Input file not found.");
     return;
   }
-  //-- read and store the GeometryTemplates
-  std::vector<GeometryTemplate*> lsGTs;
   //-- transform
   json jtransform;
   std::string l;
@@ -685,25 +788,441 @@ void read_file_cjseq(std::string &ifile, std::vector<Feature*>& lsFeatures, IOEr
         break;
       } else {
         jtransform = j["transform"];
+        set_min_xy_cjseq(jtransform);
       }
     }
     if (j["type"] == "CityJSONFeature") {
       errs.set_input_file_type("CityJSONSeq");
       j["transform"] = jtransform; //-- add transform b/c BuildingPart overlap uses a tolerance
-      parse_cjseq(j, lsFeatures, tol_snap, lsGTs);
+      try
+      {
+        parse_cjseq(j, lsFeatures, tol_snap, lsGTs);
+      }
+      catch (const json::exception& e)
+      {
+        std::string s = "Input file has an invalid CityJSONFeature at line #" + std::to_string(linecount);
+        errs.add_error(901, s);
+        break;
+      }
     }
     linecount++;
   }
 }
 
-void parse_cityjson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap)
+
+//-- one line of a CityJSONSeq, once processed by a worker thread (the features
+//-- of the lines that are dropped are deleted with it)
+struct cjseq_line
+{
+  int                                   status = 0;   //-- 0: CityJSONFeature; 1: invalid JSON; 2: other; 3: invalid CityJSONFeature
+  std::vector<std::unique_ptr<Feature>> features;
+};
+
+
+void read_file_cjseq_parallel(std::string &ifile, IOErrors& errs, double tol_snap, int jobs, std::function<void(Feature*)> validate, std::function<void(Feature*)> process)
+{
+  std::cout << "CityJSONSeq input file (" << jobs << " threads)" << std::endl;
+  std::ifstream infile(ifile.c_str(), std::ifstream::in);
+  if (!infile)
+  {
+    errs.add_error(901, "Input file not found.");
+    return;
+  }
+  //-- 1st line: the transform and the GeometryTemplates are shared (read-only) by all the features
+  std::vector<GeometryTemplate*> lsGTs;
+  json jtransform;
+  std::string l;
+  json j;
+  std::getline(infile, l);
+  try 
+  {
+    j = json::parse(l);
+  }
+  catch (nlohmann::detail::parse_error e) 
+  {
+    errs.add_error(901, "Input file has invalid JSON at line #0");
+    return;
+  }
+  if (j["type"] != "CityJSON") {
+    errs.add_error(901, "Input file first line is not a \"CityJSON\" object");
+    return;
+  }
+  if (j.count("transform") == 0) {
+    errs.add_error(901, "Input file first line has no \"transform\" property");
+    return;
+  }
+  if (j.count("geometry-templates") == 1)
+    process_cityjson_geometrytemplates(j["geometry-templates"], lsGTs, tol_snap);
+  jtransform = j["transform"];
+  set_min_xy_cjseq(jtransform);
+  //-- the other lines are parsed and validated by the workers, and given back in order
+  //-- like the serial reader, everything after an invalid line is ignored: the
+  //-- exceptions of the workers (invalid JSON, or a CityJSONFeature whose structure
+  //-- is wrong) stop the scheduling of the next lines
+  int linecount = 1;
+  process_lines_in_parallel<cjseq_line>(infile, jobs, 16 * jobs, 
+    [&](std::string& l) {
+      cjseq_line r;
+      json j = json::parse(l);
+      if (j["type"] == "CityJSONFeature") {
+        j["transform"] = jtransform; //-- add transform b/c BuildingPart overlap uses a tolerance
+        std::vector<Feature*> lsf;
+        try
+        {
+          parse_cjseq(j, lsf, tol_snap, lsGTs);
+        }
+        catch (...)
+        {
+          for (auto& f : lsf)
+            delete f;
+          throw;
+        }
+        for (auto& f : lsf)
+          r.features.emplace_back(f);
+        for (auto& f : r.features)
+          validate(f.get());
+      }
+      else
+        r.status = 2;
+      return r;
+    },
+    [&](std::string& l, const std::exception& e) {
+      cjseq_line r;
+      r.status = (dynamic_cast<const json::parse_error*>(&e) != nullptr) ? 1 : 3;
+      return r;
+    },
+    [&](cjseq_line& r) {
+      if ( (r.status == 1) || (r.status == 3) ) {
+        std::string s = (r.status == 1) ? "Input file has invalid JSON at line #" : "Input file has an invalid CityJSONFeature at line #";
+        errs.add_error(901, s + std::to_string(linecount));
+        return false;
+      }
+      for (auto& f : r.features) {
+        errs.set_input_file_type("CityJSONSeq");
+        process(f.release());
+      }
+      linecount++;
+      return true;
+    });
+  //-- all the features are processed (and deleted)
+  for (auto& gt : lsGTs)
+    delete gt;
+}
+
+//-- SAX reader for a CityJSON file, to avoid having its whole DOM in memory.
+//-- It is used in 2 passes over the file:
+//--   1. HEADER: "type", "transform" and "geometry-templates" are kept, the
+//--      "vertices" are stored in a flat array (x0, y0, z0, x1, ...), and the
+//--      ids of the children of the Buildings are collected
+//--   2. CITYOBJECTS: each City Object is built as a (small) DOM, one at a time,
+//--      and it is given to the callback oncityobject
+class cityjson_sax_reader : public nlohmann::json_sax<json>
+{
+public:
+  enum Pass { HEADER, CITYOBJECTS };
+
+  std::string                   type;
+  json                          jtransform;
+  json                          jgeomtemplates;
+  std::vector<double>           vertices;
+  int                           nocos = 0;     //-- BuildingParts are not counted
+  std::map<std::string, int>    children;      //-- <coid, #Buildings having it as child>
+  std::function<void(const std::string&, json&)> oncityobject;
+
+  cityjson_sax_reader(Pass pass) : _pass(pass) {}
+
+  bool null() override {
+    if (begin_value() == true)
+      return end_value(_dom->null());
+    return true;
+  }
+  bool boolean(bool val) override {
+    if (begin_value() == true)
+      return end_value(_dom->boolean(val));
+    return true;
+  }
+  bool number_integer(number_integer_t val) override {
+    if (begin_value() == true)
+      return end_value(_dom->number_integer(val));
+    add_coordinate(double(val));
+    return true;
+  }
+  bool number_unsigned(number_unsigned_t val) override {
+    if (begin_value() == true)
+      return end_value(_dom->number_unsigned(val));
+    add_coordinate(double(val));
+    return true;
+  }
+  bool number_float(number_float_t val, const string_t& s) override {
+    if (begin_value() == true)
+      return end_value(_dom->number_float(val, s));
+    add_coordinate(val);
+    return true;
+  }
+  bool string(string_t& val) override {
+    if (begin_value() == true)
+      return end_value(_dom->string(val));
+    if ( (_depth == 1) && (_key1 == "type") )
+      type = val;
+    else if ( (_pass == HEADER) && (_key1 == "CityObjects") ) {
+      if ( (_depth == 3) && (_key3 == "type") )
+        _cotype = val;
+      else if ( (_depth == 4) && (_key3 == "children") )
+        _cochildren.push_back(val);
+    }
+    return true;
+  }
+  bool binary(binary_t& val) override {
+    if (begin_value() == true)
+      return end_value(_dom->binary(val));
+    return true;
+  }
+  bool start_object(std::size_t elements) override {
+    bool re = true;
+    if (begin_value() == true)
+      re = _dom->start_object(elements);
+    _depth++;
+    return re;
+  }
+  bool key(string_t& val) override {
+    if (_dom != nullptr)
+      return _dom->key(val);
+    if (_depth == 1)
+      _key1 = val;
+    else if ( (_depth == 2) && (_key1 == "CityObjects") )
+      _cokey = val;
+    else if (_depth == 3)
+      _key3 = val;
+    return true;
+  }
+  bool end_object() override {
+    _depth--;
+    if (_dom != nullptr)
+      return end_value(_dom->end_object());
+    if ( (_pass == HEADER) && (_depth == 2) && (_key1 == "CityObjects") )
+      end_cityobject_header();
+    return true;
+  }
+  bool start_array(std::size_t elements) override {
+    bool re = true;
+    if (begin_value() == true)
+      re = _dom->start_array(elements);
+    _depth++;
+    return re;
+  }
+  bool end_array() override {
+    _depth--;
+    if (_dom != nullptr)
+      return end_value(_dom->end_array());
+    return true;
+  }
+  bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex) override {
+    return false;
+  }
+
+  //-- only the children that are actually City Objects in the file are kept
+  void keep_existing_children() {
+    for (auto it = children.begin(); it != children.end(); )
+    {
+      if (_allcoids.count(it->first) == 0)
+        it = children.erase(it);
+      else
+        ++it;
+    }
+    _allcoids.clear();
+  }
+
+private:
+  Pass                      _pass;
+  int                       _depth = 0;
+  std::string               _key1;
+  std::string               _key3;
+  std::string               _cokey;
+  std::string               _cotype;
+  std::vector<std::string>  _cochildren;
+  std::set<std::string>     _allcoids;
+  json                      _captured;
+  int                       _capdepth = -1;
+  std::unique_ptr<nlohmann::detail::json_sax_dom_parser<json>> _dom;
+
+  //-- returns true if the value must be passed to the DOM parser,
+  //-- starts a new DOM if the value is one we want to keep
+  bool begin_value() {
+    if (_dom != nullptr)
+      return true;
+    bool keep = false;
+    if ( (_pass == HEADER) && (_depth == 1) && ( (_key1 == "transform") || (_key1 == "geometry-templates") ) )
+      keep = true;
+    else if ( (_pass == CITYOBJECTS) && (_depth == 2) && (_key1 == "CityObjects") )
+      keep = true;
+    if (keep == true) {
+      _captured = json();
+      _capdepth = _depth;
+      _dom.reset(new nlohmann::detail::json_sax_dom_parser<json>(_captured, false));
+    }
+    return keep;
+  }
+
+  //-- finishes the DOM if the value that started it is complete
+  bool end_value(bool re) {
+    if (_depth != _capdepth)
+      return re;
+    _dom.reset();
+    _capdepth = -1;
+    if (_pass == HEADER) {
+      if (_key1 == "transform")
+        jtransform = std::move(_captured);
+      else
+        jgeomtemplates = std::move(_captured);
+    }
+    else {
+      if (oncityobject)
+        oncityobject(_cokey, _captured);
+    }
+    _captured = json();
+    return re;
+  }
+
+  void add_coordinate(double c) {
+    if ( (_pass == HEADER) && (_depth == 3) && (_key1 == "vertices") )
+      vertices.push_back(c);
+  }
+
+  void end_cityobject_header() {
+    if (_cotype != "BuildingPart")
+      nocos++;
+    if (_cotype == "Building")
+      for (auto& c : _cochildren)
+        children[c] += 1;
+    _allcoids.insert(_cokey);
+    _cotype.clear();
+    _cochildren.clear();
+    _key3.clear();
+  }
+};
+
+
+void read_file_json_stream(std::string &ifile, IOErrors& errs, double tol_snap, std::function<void(Feature*, int)> process)
+{
+  //-- 1st pass: header, vertices and geometry-templates
+  std::ifstream input(ifile);
+  if (!input)
+  {
+    errs.add_error(901, "Input file not found.");
+    return;
+  }
+  cityjson_sax_reader header(cityjson_sax_reader::HEADER);
+  if (json::sax_parse(input, &header) == false)
+  {
+    errs.add_error(901, "Input file not a valid JSON file.");
+    return;
+  }
+  input.close();
+  if (header.type != "CityJSON")
+  {
+    errs.add_error(904, "Input file type not a supported JSON file for streaming (only: CityJSON).");
+    return;
+  }
+  errs.set_input_file_type("CityJSON");
+  std::cout << "CityJSON input file (streamed)" << std::endl;
+  std::cout << "# City Objects found: " << header.nocos << std::endl;
+  header.keep_existing_children();
+  //-- compute (_minx, _miny)
+  if (header.jtransform.is_null() == false)
+    apply_json_transform(header.vertices, header.jtransform);
+  compute_min_xy(header.vertices);
+  //-- read and store the GeometryTemplates
+  std::vector<GeometryTemplate*> lsGTs;
+  if (header.jgeomtemplates.is_null() == false)
+    process_cityjson_geometrytemplates(header.jgeomtemplates, lsGTs, tol_snap);
+  header.jgeomtemplates = json();
+
+  //-- 2nd pass: each CO is processed as soon as it's read. A Building waits
+  //-- until all its children are read, and the children are kept until all their
+  //-- Buildings are processed (in most files they follow each other anyway)
+  std::map<std::string, json>                     kids;      //-- children read
+  std::map<std::string, std::tuple<json, int>>    waiting;   //-- <Building, #children missing>
+  std::map<std::string, std::vector<std::string>> waitingfor;
+  auto process_building = [&](const std::string& coid, json& jco) {
+    CityObject* co = new CityObject(coid, jco["type"]);
+    process_json_geometries_of_co(jco, co, coid, lsGTs, header.vertices, tol_snap);
+    if (jco.count("children") != 0)
+    {
+      for (std::string bpid : jco["children"])
+      {
+        auto it = kids.find(bpid);
+        if (it == kids.end())
+          continue;
+        process_json_geometries_of_co(it->second, co, bpid, lsGTs, header.vertices, tol_snap);
+        if (--header.children[bpid] == 0)
+          kids.erase(it);
+      }
+    }
+    process(co, header.nocos);
+  };
+  cityjson_sax_reader reader(cityjson_sax_reader::CITYOBJECTS);
+  reader.oncityobject = [&](const std::string& coid, json& jco) {
+    bool ischild = (header.children.count(coid) != 0);
+    if (ischild == true)
+      kids[coid] = jco;
+    if (jco["type"] != "BuildingPart")
+    {
+      int missing = 0;
+      if ( (jco["type"] == "Building") && (jco.count("children") != 0) )
+      {
+        for (std::string bpid : jco["children"])
+        {
+          if ( (header.children.count(bpid) != 0) && (kids.count(bpid) == 0) )
+          {
+            waitingfor[bpid].push_back(coid);
+            missing++;
+          }
+        }
+      }
+      if (missing == 0)
+        process_building(coid, jco);
+      else
+        waiting[coid] = std::make_tuple(jco, missing);
+    }
+    if (ischild == true)
+    {
+      auto it = waitingfor.find(coid);
+      if (it != waitingfor.end())
+      {
+        for (auto& bid : it->second)
+        {
+          auto& w = waiting[bid];
+          if (--std::get<1>(w) == 0)
+          {
+            process_building(bid, std::get<0>(w));
+            waiting.erase(bid);
+          }
+        }
+        waitingfor.erase(it);
+      }
+    }
+  };
+  input.open(ifile);
+  if (json::sax_parse(input, &reader) == false)
+  {
+    errs.add_error(901, "Input file not a valid JSON file.");
+    return;
+  }
+  //-- Buildings whose children are never complete (should not happen)
+  for (auto& w : waiting)
+    process_building(w.first, std::get<0>(w.second));
+  for (auto& gt : lsGTs)
+    delete gt;
+}
+
+void parse_cityjson(json& j, std::vector<Feature*>& lsFeatures, std::vector<GeometryTemplate*>& lsGTs, double tol_snap)
 {
   std::cout << "CityJSON input file" << std::endl;
   std::cout << "# City Objects found: " << j["CityObjects"].size() << std::endl;
   //-- compute (_minx, _miny)
-  compute_min_xy(j);
+  std::vector<double> vertices;
+  decode_json_vertices(j, vertices, true);
   //-- read and store the GeometryTemplates
-  std::vector<GeometryTemplate*> lsGTs;
   if (j.count("geometry-templates") == 1)
   {
     process_cityjson_geometrytemplates(j["geometry-templates"], lsGTs, tol_snap);
@@ -715,13 +1234,13 @@ void parse_cityjson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap)
     if (it.value()["type"] == "BuildingPart")
       continue;
     CityObject* co = new CityObject(it.key(), it.value()["type"]);
-    process_json_geometries_of_co(it.value(), co, co->get_id(), lsGTs, j, tol_snap);
+    process_json_geometries_of_co(it.value(), co, co->get_id(), lsGTs, vertices, tol_snap);
     //-- if Building has Parts, put them here in _lsPrimitives
     if ( (it.value()["type"] == "Building") && (it.value().count("children") != 0) ) 
     {
       for (std::string bpid : it.value()["children"])
       {
-        process_json_geometries_of_co(j["CityObjects"][bpid], co, bpid, lsGTs, j, tol_snap);
+        process_json_geometries_of_co(j["CityObjects"][bpid], co, bpid, lsGTs, vertices, tol_snap);
       }
     }
     lsFeatures.push_back(co);
@@ -730,8 +1249,10 @@ void parse_cityjson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap)
 
 void parse_cjseq(json& j, std::vector<Feature*>& lsFeatures, double tol_snap, std::vector<GeometryTemplate*>& lsGTs)
 {
-  //-- compute (_minx, _miny)
-  compute_min_xy(j);
+  //-- (_minx, _miny) is set once for the whole CityJSONSeq (set_min_xy_cjseq()), 
+  //-- so that features can be parsed independently (and in parallel)
+  std::vector<double> vertices;
+  decode_json_vertices(j, vertices, false);
   //-- process each CO
   for (json::iterator it = j["CityObjects"].begin(); it != j["CityObjects"].end(); ++it) 
   {
@@ -739,13 +1260,13 @@ void parse_cjseq(json& j, std::vector<Feature*>& lsFeatures, double tol_snap, st
     if (it.value()["type"] == "BuildingPart")
       continue;
     CityObject* co = new CityObject(it.key(), it.value()["type"]);
-    process_json_geometries_of_co(it.value(), co, co->get_id(), lsGTs, j, tol_snap);
+    process_json_geometries_of_co(it.value(), co, co->get_id(), lsGTs, vertices, tol_snap);
     //-- if Building has Parts, put them here in _lsPrimitives
     if ( (it.value()["type"] == "Building") && (it.value().count("children") != 0) ) 
     {
       for (std::string bpid : it.value()["children"])
       {
-        process_json_geometries_of_co(j["CityObjects"][bpid], co, bpid, lsGTs, j, tol_snap);
+        process_json_geometries_of_co(j["CityObjects"][bpid], co, bpid, lsGTs, vertices, tol_snap);
       }
     }
     lsFeatures.push_back(co);
@@ -755,6 +1276,15 @@ void parse_cjseq(json& j, std::vector<Feature*>& lsFeatures, double tol_snap, st
 
 void process_cityjson_geometrytemplates(json& j, std::vector<GeometryTemplate*>& lsGTs, double tol_snap)
 {
+  //-- the vertices of the templates are not transformed/translated
+  std::vector<double> vertices;
+  vertices.reserve(3 * j["vertices-templates"].size());
+  for (auto& v : j["vertices-templates"])
+  {
+    vertices.push_back(double(v[0]));
+    vertices.push_back(double(v[1]));
+    vertices.push_back(double(v[2]));
+  }
   int count = 0;
   for (auto& jt : j["templates"])
   {
@@ -770,7 +1300,7 @@ void process_cityjson_geometrytemplates(json& j, std::vector<GeometryTemplate*>&
         c++;
         for (auto& polygon : shell) { 
           std::vector< std::vector<int> > pa = polygon;
-          process_json_surface_geometrytemplate(pa, j, sh);
+          process_json_surface_geometrytemplate(pa, vertices, sh);
         }
         if (oshell == true)
         {
@@ -788,7 +1318,7 @@ void process_cityjson_geometrytemplates(json& j, std::vector<GeometryTemplate*>&
       for (auto& p : jt["boundaries"]) 
       { 
         std::vector< std::vector<int> > pa = p;
-        process_json_surface_geometrytemplate(pa, j, sh);
+        process_json_surface_geometrytemplate(pa, vertices, sh);
       }
       if (jt["type"] == "MultiSurface")
       {
@@ -809,7 +1339,7 @@ void process_cityjson_geometrytemplates(json& j, std::vector<GeometryTemplate*>&
 }
 
 
-void process_json_surface_geometrytemplate(std::vector< std::vector<int> >& pgn, json& j, Surface* sh)
+void process_json_surface_geometrytemplate(std::vector< std::vector<int> >& pgn, const std::vector<double>& vertices, Surface* sh)
 {
   std::vector< std::vector<int> > pgnids;
   for (auto& r : pgn)
@@ -817,13 +1347,7 @@ void process_json_surface_geometrytemplate(std::vector< std::vector<int> >& pgn,
     std::vector<int> newr;
     for (auto& i : r)
     {
-      double x;
-      double y;
-      double z;
-      x = double(j["vertices-templates"][i][0]);
-      y = double(j["vertices-templates"][i][1]);
-      z = double(j["vertices-templates"][i][2]);
-      Point3 p3(x, y, z);
+      Point3 p3(vertices.at(3 * i), vertices.at(3 * i + 1), vertices.at(3 * i + 2));
       newr.push_back(sh->add_point(p3));
     }
     pgnids.push_back(newr);
@@ -832,7 +1356,7 @@ void process_json_surface_geometrytemplate(std::vector< std::vector<int> >& pgn,
 }
 
 
-void process_gml_file_indoorgml(pugi::xml_document& doc, std::vector<Feature*>& lsFeatures, std::map<std::string, pugi::xpath_node>& dallpoly, IOErrors& errs, double tol_snap)
+void process_gml_file_indoorgml(pugi::xml_document& doc, std::vector<Feature*>& lsFeatures, GMLIndex& gmlindex, IOErrors& errs, double tol_snap)
 {
   //-- 0. read the header of the file and find its gml:name, if any
   std::string nameim = "";
@@ -884,7 +1408,7 @@ void process_gml_file_indoorgml(pugi::xml_document& doc, std::vector<Feature*>&
         for (pugi::xml_node child3 : child2.children(s.c_str()))
         {
           // std::cout << "Solid: " << child3.attribute("gml:id").value() << std::endl;
-          sol = process_gml_solid(child3, dallpoly, tol_snap, errs);
+          sol = process_gml_solid(child3, gmlindex, tol_snap, errs);
           if (sol->get_id() == "")
             sol->set_id("MISSING_ID");
           // cell->add_primitive(sol);
@@ -959,23 +1483,11 @@ void process_gml_file_indoorgml(pugi::xml_document& doc, std::vector<Feature*>&
       }
       s = ".//" + NS["gml"] + "pos";
       pugi::xpath_node n = it->node().select_node(s.c_str());
-      // std::cout << n.node().child_value() << std::endl;
-      
-      std::string buf;
-      std::stringstream ss(n.node().child_value());
-      std::vector<std::string> tokens;
-      while (ss >> buf)
-        tokens.push_back(buf);
-      // long double x = std::stold(tokens[0]);
-      // long double y = std::stold(tokens[1]);
-      // long double z = std::stold(tokens[2]);
-      // TODO: use long double?
-      ig->add_vertex(vid, 
-                     std::stold(tokens[0]), 
-                     std::stold(tokens[1]), 
-                     std::stold(tokens[2]),
-                     vdual,
-                     vadj);
+      const double* c;
+      std::size_t size;
+      if ( (gmlindex.get_coords(n.node(), c, size) == false) || (size < 3) )
+        throw 901;
+      ig->add_vertex(vid, c[0], c[1], c[2], vdual, vadj);
     }
     im->add_graph(ig);
   }
@@ -993,60 +1505,23 @@ void set_min_xy(double minx, double miny)
   Surface::set_translation_min_values(_minx, _miny);
 }
 
-void compute_min_xy(json& j)
+//-- for a CityJSONSeq the translation is the "translate" of the 1st line, it's
+//-- known before any feature is read and it's (usually) the min of the dataset
+void set_min_xy_cjseq(json& jtransform)
 {
-  for (auto& v : j["vertices"])
-  {
-    if (v[0] < _minx)
-      _minx = v[0];
-    if (v[1] < _miny)
-      _miny = v[1];
-  }
-  if (j.count("transform") != 0)
-  {
-    _minx = (_minx * double(j["transform"]["scale"][0])) + double(j["transform"]["translate"][0]);
-    _miny = (_miny * double(j["transform"]["scale"][1])) + double(j["transform"]["translate"][1]);
-  }
-  // std::cout << "Translating all coordinates by (-" << _minx << ", -" << _miny << ")" << std::endl;
-  Primitive::set_translation_min_values(_minx, _miny);
-  Surface::set_translation_min_values(_minx, _miny);
+  set_min_xy(double(jtransform["translate"][0]), double(jtransform["translate"][1]));
 }
 
 
-void compute_min_xy(pugi::xml_document& doc)
+void compute_min_xy(const std::vector<double>& vertices)
 {
-  std::string s = "//" + NS["gml"] + "posList";
-  pugi::xpath_node_set nall = doc.select_nodes(s.c_str());
-  for (auto& each : nall) 
+  for (std::size_t i = 0; i + 2 < vertices.size(); i += 3)
   {
-    std::string buf;
-    std::stringstream ss(each.node().child_value());
-    std::vector<std::string> coords;
-    while (ss >> buf)
-      coords.push_back(buf);
-    for (int i = 0; i < coords.size(); i += 3)
-    {
-      if (std::stod(coords[0]) < _minx)
-        _minx = std::stod(coords[0]);
-      if (std::stod(coords[1]) < _miny)
-        _miny = std::stod(coords[1]);
-    }
+    if (vertices[i] < _minx)
+      _minx = vertices[i];
+    if (vertices[i + 1] < _miny)
+      _miny = vertices[i + 1];
   }
-  s = "//" + NS["gml"] + "pos";
-  nall = doc.select_nodes(s.c_str());
-  for (auto& each : nall) 
-  {
-    std::string buf;
-    std::stringstream ss(each.node().child_value());
-    std::vector<std::string> tokens;
-    while (ss >> buf)
-      tokens.push_back(buf);
-    if (std::stod(tokens[0]) < _minx)
-      _minx = std::stod(tokens[0]);
-    if (std::stod(tokens[1]) < _miny)
-      _miny = std::stod(tokens[1]);
-  }
-  // std::cout << "Translating all coordinates by (-" << _minx << ", -" << _miny << ")" << std::endl;
   Primitive::set_translation_min_values(_minx, _miny);
   Surface::set_translation_min_values(_minx, _miny);
 }
@@ -1055,13 +1530,17 @@ void compute_min_xy(pugi::xml_document& doc)
 void read_file_gml(std::string &ifile, std::vector<Feature*>& lsFeatures, IOErrors& errs, double tol_snap)
 {
   std::cout << "Reading file: " << ifile << std::endl;
+  //-- the file is mapped in memory (copy-on-write) and parsed in-place, so that
+  //-- it's not copied in the heap of pugixml. The mapping must outlive doc.
+  MappedFile mf;
+  if (mf.open(ifile, true) == false) {
+    errs.add_error(901, "Input file not found.");
+    return;
+  }
   pugi::xml_document doc;
-  pugi::xml_parse_result result = doc.load_file(ifile.c_str());
+  pugi::xml_parse_result result = doc.load_buffer_inplace(mf.data(), mf.size());
   if (!result) {
-    if (result.status == pugi::status_file_not_found)
-      errs.add_error(901, "Input file not found.");
-    else
-      errs.add_error(901, result.description());
+    errs.add_error(901, result.description());
     return;
   }
   //-- parse namespace
@@ -1069,13 +1548,11 @@ void read_file_gml(std::string &ifile, std::vector<Feature*>& lsFeatures, IOErro
   get_namespaces(ncm); //-- results in global variable NS in this unit
   if ( (NS.count("indoorgml") != 0) && (ncm.name() == (NS["indoorgml"] + "IndoorFeatures")) ) {
     std::cout << "IndoorGML input file" << std::endl;
-    //-- find (_minx, _miny)
-    compute_min_xy(doc);
-    //-- build dico of xlinks for <gml:Polygon>
-    std::map<std::string, pugi::xpath_node> dallpoly;
-    build_dico_xlinks(doc, dallpoly, errs);
+    //-- find (_minx, _miny), parse the coordinates and build dico of xlinks for <gml:Polygon>
+    GMLIndex gmlindex;
+    build_gml_index(doc, gmlindex, errs);
     errs.set_input_file_type("IndoorGML");
-    process_gml_file_indoorgml(doc, lsFeatures, dallpoly, errs, tol_snap);
+    process_gml_file_indoorgml(doc, lsFeatures, gmlindex, errs, tol_snap);
   }
   else
   {
@@ -1119,117 +1596,228 @@ std::map<std::string, std::string> get_namespaces(pugi::xml_node& root) {
 }
 
 
-void build_dico_xlinks(pugi::xml_document& doc, std::map<std::string, pugi::xpath_node>& dallpoly, IOErrors& errs)
+bool GMLIndex::get_coords(const pugi::xml_node& n, const double*& c, std::size_t& size)
 {
-  std::string s = "//" + NS["gml"] + "Polygon" + "[@" + NS["gml"] + "id]";
-  pugi::xpath_node_set nallpoly = doc.select_nodes(s.c_str());
-  if (nallpoly.size() > 0)
-   std::cout << "XLinks found, resolving them..." << std::flush;
-  for (pugi::xpath_node_set::const_iterator it = nallpoly.begin(); it != nallpoly.end(); ++it)
-    dallpoly[it->node().attribute("gml:id").value()] = *it;
-  //-- for <gml:OrientableSurface>
-  s = "//" + NS["gml"] + "OrientableSurface" + "[@" + NS["gml"] + "id" + "]";
-  pugi::xpath_node_set nallosurf = doc.select_nodes(s.c_str());
-  for (pugi::xpath_node_set::const_iterator it = nallosurf.begin(); it != nallosurf.end(); ++it)
-    dallpoly[it->node().attribute("gml:id").value()] = *it;
+  auto it = dcoords.find(n.hash_value());
+  if ( (it == dcoords.end()) || (it->second.valid == false) )
+    return false;
+  c = coords.data() + it->second.start;
+  size = it->second.size;
+  return true;
+}
+
+
+bool gml_index_walker::begin(pugi::xml_node& node)
+{
+  spolygon       = NS["gml"] + "Polygon";
+  sosurface      = NS["gml"] + "OrientableSurface";
+  ssurfacemember = NS["gml"] + "surfaceMember";
+  spos           = NS["gml"] + "pos";
+  sposlist       = NS["gml"] + "posList";
+  sgmlid         = NS["gml"] + "id";
+  shref          = NS["xlink"] + "href";
+  return true;
+}
+
+
+bool gml_index_walker::for_each(pugi::xml_node& node)
+{
+  if (node.type() != pugi::node_element)
+    return true;
+  const char* name = node.name();
+  if ( (spolygon == name) || (sosurface == name) ) 
+  {
+    pugi::xml_attribute id = node.attribute(sgmlid.c_str());
+    if (id)
+      index.dallpoly[id.value()] = node;
+  }
+  else if (ssurfacemember == name) 
+  {
+    if (node.attribute(shref.c_str()) != 0)
+      index.xlinks.push_back(node);
+  }
+  else if ( (spos == name) || (sposlist == name) ) 
+  {
+    //-- the coordinates are parsed here, and only here
+    GMLIndex::Coords gc;
+    gc.start = index.coords.size();
+    gc.valid = true;
+    TextScanner ts(node.child_value(), node.child_value() + strlen(node.child_value()));
+    double v;
+    while (ts.eof() == false)
+    {
+      if (ts.read_double(v) == false) {
+        gc.valid = false;
+        break;
+      }
+      index.coords.push_back(v);
+    }
+    gc.size = index.coords.size() - gc.start;
+    //-- (minx, miny) of all the points
+    for (std::size_t i = gc.start; i + 1 < index.coords.size(); i += 3)
+    {
+      if (index.coords[i] < index.minx)
+        index.minx = index.coords[i];
+      if (index.coords[i + 1] < index.miny)
+        index.miny = index.coords[i + 1];
+    }
+    index.dcoords[node.hash_value()] = gc;
+  }
+  return true;
+}
+
+
+void build_gml_index(pugi::xml_document& doc, GMLIndex& gmlindex, IOErrors& errs)
+{
+  gml_index_walker w(gmlindex);
+  doc.traverse(w);
+  //-- (_minx, _miny)
+  if (gmlindex.minx < _minx)
+    _minx = gmlindex.minx;
+  if (gmlindex.miny < _miny)
+    _miny = gmlindex.miny;
+  // std::cout << "Translating all coordinates by (-" << _minx << ", -" << _miny << ")" << std::endl;
+  Primitive::set_translation_min_values(_minx, _miny);
+  Surface::set_translation_min_values(_minx, _miny);
   //-- checking xlinks validity now, not to be bitten later
-  s = "//" + NS["gml"] + "surfaceMember" + "[@" + NS["xlink"] + "href" + "]";
-  pugi::xpath_node_set nsmxlink = doc.select_nodes(s.c_str());
-  for (pugi::xpath_node_set::const_iterator it = nsmxlink.begin(); it != nsmxlink.end(); ++it) 
+  if (gmlindex.dallpoly.size() > 0)
+   std::cout << "XLinks found, resolving them..." << std::flush;
+  for (auto& n : gmlindex.xlinks) 
   {
-    std::string k = it->node().attribute("xlink:href").value();
+    std::string k = n.attribute("xlink:href").value();
     if (k[0] == '#')
       k = k.substr(1);
-    if (dallpoly.count(k) == 0) 
+    if (gmlindex.dallpoly.count(k) == 0) 
     {
       std::string r = "One XLink couldn't be resolved (";
-      r += it->node().attribute("xlink:href").value();
+      r += n.attribute("xlink:href").value();
       r += ")";
       errs.add_error(901, r);
       return;
     }
   }
-  if (nallpoly.size() > 0)
+  if (gmlindex.dallpoly.size() > 0)
     std::cout << "done." << std::endl;
 }
 
 
-Surface* parse_poly(std::istream &input, int shellid, IOErrors& errs)
+Surface* parse_poly(const char* buf, std::size_t len, int shellid, IOErrors& errs)
 {
-  //-- read the points
+  TextScanner ts(buf, buf + len);
+  //-- read the points, (_minx, _miny) is computed at the same time
   int num, tmpint;
-  float tmpfloat;
-  double x, y, z;
-  input >> num >> tmpint >> tmpint >> tmpint;
-  //-- compute (_minx, _miny)
+  double tmpdouble;
+  if ( (ts.read_int(num) == false) || (ts.read_int(tmpint) == false) || 
+       (ts.read_int(tmpint) == false) || (ts.read_int(tmpint) == false) || (num < 0) ) {
+    errs.add_error(901, "Input file not a valid POLY file.");
+    return NULL;
+  }
+  std::vector<double> vertices;
+  vertices.reserve(3 * num);
+  //-- the vertices are numbered from 0 or 1, the first one tells
+  int firstid = 0;
   for (int i = 0; i < num; i++)
   {
-    input >> tmpint >> x >> y >> z;
+    double x, y, z;
+    if ( (ts.read_int(tmpint) == false) || (ts.read_double(x) == false) || 
+         (ts.read_double(y) == false) || (ts.read_double(z) == false) ) {
+      errs.add_error(901, "Input file not a valid POLY file (vertex #" + std::to_string(i) + ").");
+      return NULL;
+    }
+    if (i == 0)
+      firstid = tmpint;
     if (x < _minx)
       _minx = x;
     if (y < _miny)
       _miny = y;
+    vertices.push_back(x);
+    vertices.push_back(y);
+    vertices.push_back(z);
   }
   // std::cout << "Translating all coordinates by (-" << _minx << ", -" << _miny << ")" << std::endl;
   Primitive::set_translation_min_values(_minx, _miny);
   Surface::set_translation_min_values(_minx, _miny);
-  input.clear();
-  input.seekg(0);
-  input >> num >> tmpint >> tmpint >> tmpint;
-  //-- read verticess
   Surface* sh = new Surface("");  
-  for (int i = 0; i < num; i++)
+  for (std::size_t i = 0; i < vertices.size(); i += 3)
   {
-    input >> tmpint >> x >> y >> z;
-    x -= _minx;
-    y -= _miny;
-    Point3 p(x, y, z);
+    Point3 p(vertices[i] - _minx, vertices[i + 1] - _miny, vertices[i + 2]);
     sh->add_point(p);
   }
   //-- read the facets
-  input >> num >> tmpint;
+  int numv = num;
+  if ( (ts.read_int(num) == false) || (ts.read_int(tmpint) == false) ) {
+    errs.add_error(901, "Input file not a valid POLY file.");
+    delete sh;
+    return NULL;
+  }
   int numf, numpt, numholes;
-  string s;
   for (int i = 0; i < num; i++)
   {
     numholes = 0;
-    input >> numf;
-    while(true) {
-      if (input.peek() == '\n')
-        break;
-      else if (input.peek() == ' ')
-        input.ignore();
-      else
-        input >> numholes;
+    if (ts.read_int(numf) == false) {
+      errs.add_error(901, "Input file not a valid POLY file (facet #" + std::to_string(i) + ").");
+      delete sh;
+      return NULL;
     }
-    //-- read oring (there's always one and only one)
-    input >> numpt;
-    if (numpt == -1) {
-      sh->add_error(103, std::to_string(i));
-      continue;
+    //-- "#polygons [#holes [boundary marker]]"
+    bool valid = true;
+    if (ts.at_eol() == false)
+      valid = ts.read_int(numholes);
+    if ( (valid == true) && (ts.at_eol() == false) )
+      valid = ts.read_int(tmpint);
+    if ( (valid == false) || (numholes < 0) || (ts.at_eol() == false) ) {
+      errs.add_error(901, "Input file not a valid POLY file (facet #" + std::to_string(i) + ").");
+      delete sh;
+      return NULL;
     }
-    std::vector<int> ids(numpt);
-    for (int k = 0; k < numpt; k++)
-      input >> ids[k];
     std::vector< std::vector<int> > pgnids;
-    pgnids.push_back(ids);
-    //-- check for irings
-    for (int j = 1; j < numf; j++)
+    bool skip = false;
+    for (int j = 0; j < numf; j++)
     {
-      input >> numpt;
+      if (ts.read_int(numpt) == false) {
+        errs.add_error(901, "Input file not a valid POLY file (facet #" + std::to_string(i) + ").");
+        delete sh;
+        return NULL;
+      }
       if (numpt == -1) {
         sh->add_error(103, std::to_string(i));
+        if (j == 0)  //-- oring (there's always one and only one)
+          skip = true;
         continue;
       }
+      if (numpt < 0) {
+        errs.add_error(901, "Input file not a valid POLY file (facet #" + std::to_string(i) + ").");
+        delete sh;
+        return NULL;
+      }
       std::vector<int> ids(numpt);
-      for (int l = 0; l < numpt; l++)
-        input >> ids[l];
+      for (int k = 0; k < numpt; k++) {
+        if (ts.read_int(ids[k]) == false) {
+          errs.add_error(901, "Input file not a valid POLY file (facet #" + std::to_string(i) + ").");
+          delete sh;
+          return NULL;
+        }
+        if ( (ids[k] < firstid) || (ids[k] >= (numv + firstid)) ) {
+          errs.add_error(901, "Vertex #" + std::to_string(ids[k]) + " doesn't exist in the input file.");
+          delete sh;
+          return NULL;
+        }
+        ids[k] -= firstid;
+      }
       pgnids.push_back(ids);
     }
     //-- skip the line about points defining holes (if present)
     for (int j = 0; j < numholes; j++)
-      input >> tmpint >> tmpfloat >> tmpfloat >> tmpfloat;
-    sh->add_face(pgnids);
+    {
+      if ( (ts.read_int(tmpint) == false) || (ts.read_double(tmpdouble) == false) ||
+           (ts.read_double(tmpdouble) == false) || (ts.read_double(tmpdouble) == false) ) {
+        errs.add_error(901, "Input file not a valid POLY file (hole point of facet #" + std::to_string(i) + ").");
+        delete sh;
+        return NULL;
+      }
+    }
+    if (skip == false)
+      sh->add_face(pgnids);
   }
   return sh;
 }
@@ -1253,62 +1841,65 @@ void printProgressBar(int percent) {
 }
 
 
-Surface* parse_off(std::istream &input, int shellid, IOErrors& errs, double tol_snap)
+Surface* parse_off(const char* buf, std::size_t len, int shellid, IOErrors& errs, double tol_snap)
 {
-  //-- read the points
+  TextScanner ts(buf, buf + len);
+  //-- read the points, (_minx, _miny) is computed at the same time
   int numpt, numf, tmpint;
-  std::string s;
-  input >> s;
-  input >> numpt >> numf >> tmpint;
-  if ( (s != "OFF") || (numpt <= 0) ) {
+  if ( (ts.read_word() != "OFF") || (ts.read_int(numpt) == false) || (ts.read_int(numf) == false) || 
+       (ts.read_int(tmpint) == false) || (numpt <= 0) ) {
     errs.add_error(901, "Input file not a valid OFF file.");
     return NULL;
   }
-  //-- compute (_minx, _miny)
+  std::vector<double> vertices;
+  vertices.reserve(3 * numpt);
   for (int i = 0; i < numpt; i++)
   {
     double x, y, z;
-    input >> x >> y >> z;
+    if ( (ts.read_double(x) == false) || (ts.read_double(y) == false) || (ts.read_double(z) == false) ) {
+      errs.add_error(901, "Input file not a valid OFF file (vertex #" + std::to_string(i) + ").");
+      return NULL;
+    }
     if (x < _minx)
       _minx = x;
     if (y < _miny)
       _miny = y;
+    vertices.push_back(x);
+    vertices.push_back(y);
+    vertices.push_back(z);
   }
   // std::cout << "Translating all coordinates by (-" << _minx << ", -" << _miny << ")" << std::endl;
   Primitive::set_translation_min_values(_minx, _miny);
   Surface::set_translation_min_values(_minx, _miny);
-  //-- reset the file
-  input.clear();
-  input.seekg(0);
-  input >> s;
-  input >> numpt >> numf >> tmpint;
-  //-- read the points
-  std::vector<int> newi;
+  std::vector<int> newi(numpt);
   Surface* sh = new Surface("", tol_snap);
   for (int i = 0; i < numpt; i++)
   {
-    double x, y, z;
-    input >> x >> y >> z;
-    x -= _minx;
-    y -= _miny;
-    Point3 p(x, y, z);
-    newi.push_back(sh->add_point(p));
+    Point3 p(vertices[3 * i] - _minx, vertices[3 * i + 1] - _miny, vertices[3 * i + 2]);
+    newi[i] = sh->add_point(p);
   }
   //-- read the facets
   for (int i = 0; i < numf; i++)
   {
-    input >> tmpint;
-    std::vector<int> ids(tmpint);
-    if (ids.empty() == true)
+    if ( (ts.read_int(tmpint) == false) || (tmpint <= 0) )
     {
       errs.add_error(901, "Some surfaces not defined correctly or are empty");
+      delete sh;
       return NULL;
     }
+    std::vector<int> ids(tmpint);
     for (int k = 0; k < tmpint; k++) {
       int t;
-      input >> t;
+      if ( (ts.read_int(t) == false) || (t < 0) || (t >= numpt) ) {
+        errs.add_error(901, "Vertex #" + std::to_string(t) + " doesn't exist in the input file.");
+        delete sh;
+        return NULL;
+      }
       ids[k] = newi[t];
     }
+    //-- colours, if any, are ignored
+    while (ts.at_eol() == false)
+      ts.read_word();
     std::vector< std::vector<int> > pgnids;
     pgnids.push_back(ids);
     sh->add_face(pgnids);
@@ -1317,138 +1908,134 @@ Surface* parse_off(std::istream &input, int shellid, IOErrors& errs, double tol_
 }
 
 
-void parse_obj(std::istream &input, std::vector<Feature*>& lsFeatures, Primitive3D prim3d, IOErrors& errs, double tol_snap)
+//-- the faces of one "o" of an OBJ file, in a flat array: 
+//-- (#vertices of face0, v0, v1, ..., #vertices of face1, v0, ...)
+struct obj_object {
+  std::string       id;
+  std::vector<int>  faces;
+  int               nofaces = 0;
+};
+
+void parse_obj(const char* buf, std::size_t len, std::vector<Feature*>& lsFeatures, Primitive3D prim3d, IOErrors& errs, double tol_snap)
 {
-  //-- find (minx, miny)
-  std::string l;
-  while (std::getline(input, l)) 
+  //-- the file is read once: the vertices are stored in a flat array and 
+  //-- (_minx, _miny) is computed at the same time, the faces are kept as indices
+  TextScanner ts(buf, buf + len);
+  std::vector<double> vertices;
+  std::vector<obj_object> objects(1);
+  objects.back().id = "none";
+  while (ts.eof() == false) 
   {
-    std::istringstream iss(l);
-    if (l.substr(0, 2) == "v ") {
-      std::string tmp;
+    std::string_view tag = ts.read_word();
+    if (tag == "v") {
       double x, y, z;
-      iss >> tmp >> x >> y >> z;
+      if ( (ts.read_double(x) == false) || (ts.read_double(y) == false) || (ts.read_double(z) == false) ) {
+        std::string r = "Vertex #";
+        r += std::to_string(vertices.size() / 3 + 1);
+        r += " not defined correctly.";
+        errs.add_error(901, r);
+        return;
+      }
       if (x < _minx)
         _minx = x;
       if (y < _miny)
         _miny = y;
-    }
-  }
-  // std::cout << "Translating all coordinates by (-" << _minx << ", -" << _miny << ")" << std::endl;
-  Primitive::set_translation_min_values(_minx, _miny);
-  Surface::set_translation_min_values(_minx, _miny);
-  //-- read again file and parse everything
-  input.clear();
-  input.seekg(0);
-  std::string oid = "none";
-  GenericObject* o = new GenericObject(oid);
-  Surface* sh = new Surface("", tol_snap);
-  std::vector<Point3*> allvertices;
-  while (std::getline(input, l)) {
-    std::istringstream iss(l);
-    if (l.substr(0, 2) == "v ") {
-      std::string tmp;
-      double x, y, z;
-      iss >> tmp >> x >> y >> z;
-      x -= _minx;
-      y -= _miny;
-      Point3 *p = new Point3(x, y, z);
-      allvertices.push_back(p);
-    }
-    else if (l.substr(0, 2) == "o ") {
-      if (sh->is_empty() == true) { //-- for the first "o" before any faces
-        std::string tmp;
-        iss >> tmp >> oid; 
-        o->set_id(oid);
-      }
-      else{
-        if (prim3d == SOLID)
-        {
-          Solid* sol = new Solid("");
-          sol->set_oshell(sh);
-          o->add_primitive(sol);
-        }
-        else if ( prim3d == COMPOSITESURFACE)
-        {
-          CompositeSurface* cs = new CompositeSurface("");
-          cs->set_surface(sh);
-          o->add_primitive(cs);
-        }
-        else if (prim3d == MULTISURFACE)
-        {
-          MultiSurface* ms = new MultiSurface("");
-          ms->set_surface(sh);
-          o->add_primitive(ms);
-        }
-        lsFeatures.push_back(o);
-        std::string tmp;
-        iss >> tmp >> oid; 
-        o = new GenericObject(oid);
-        sh = new Surface("", tol_snap);
+      vertices.push_back(x);
+      vertices.push_back(y);
+      vertices.push_back(z);
+    }
+    else if (tag == "o") {
+      std::string oid(ts.read_word_on_line());
+      if (objects.back().nofaces == 0) //-- for the first "o" before any faces
+        objects.back().id = oid;
+      else {
+        objects.emplace_back();
+        objects.back().id = oid;
       }
     }
-    else if (l.substr(0, 2) == "f ") {
-      std::vector<int> r;
-      std::string tmp;
-      iss >> tmp;
-      while (iss)
+    else if (tag == "f") {
+      obj_object& o = objects.back();
+      std::size_t start = o.faces.size();
+      o.faces.push_back(0);
+      while (true)
       {
-        tmp.clear();
-        iss >> tmp;
-        if (tmp.compare("\\") == 0) {
-          std::getline(input, l);
-          iss.str(l);
+        std::string_view tmp = ts.read_word_on_line();
+        if (tmp.empty() == true)
+          break;
+        if (tmp == "\\") {
+          ts.skip_line();
           continue;
         }
-        if (tmp.empty() == false) {
-          std::size_t k = tmp.find("/");
-          int index = std::stoi(tmp.substr(0, k));
-          if (index == 0) {
-            errs.add_error(901, "OBJ files are 1-indexed, vertex '0' found.");
-            return;
-          }
-          if (index > allvertices.size()) {
-            std::string r = "Vertex #";
-            r += std::to_string(index);
-            r += " doesn't exist in the input file.";
-            errs.add_error(901, r);
-            return;
-          }
-          Point3* tp = allvertices[index - 1];
-          r.push_back(sh->add_point(*tp));
+        //-- "v/vt/vn": only v is used
+        int index;
+        auto re = std::from_chars(tmp.data(), tmp.data() + tmp.size(), index);
+        if (re.ec != std::errc()) {
+          errs.add_error(901, "Face with an invalid vertex '" + std::string(tmp) + "'.");
+          return;
         }
+        if (index == 0) {
+          errs.add_error(901, "OBJ files are 1-indexed, vertex '0' found.");
+          return;
+        }
+        if ( (index < 0) || (index > int(vertices.size() / 3)) ) {
+          std::string r = "Vertex #";
+          r += std::to_string(index);
+          r += " doesn't exist in the input file.";
+          errs.add_error(901, r);
+          return;
+        }
+        o.faces.push_back(index - 1);
+        o.faces[start]++;
       }
-      std::vector< std::vector<int> > pgnids;
-      pgnids.push_back(r);
-      sh->add_face(pgnids);
+      o.nofaces++;
     }
+    ts.skip_line();
   }
-  if (sh->is_empty() == true) {
+  if (objects.back().nofaces == 0) {
     errs.add_error(902, "Some surfaces are not defined correctly or are empty");
     return;
   }
-  if (prim3d == SOLID)
-  {
-    Solid* sol = new Solid("");
-    sol->set_oshell(sh);
-    o->add_primitive(sol);
-  }
-  else if ( prim3d == COMPOSITESURFACE)
-  {
-    CompositeSurface* cs = new CompositeSurface("");
-    cs->set_surface(sh);
-    o->add_primitive(cs);
-  }
-  else if (prim3d == MULTISURFACE)
+  // std::cout << "Translating all coordinates by (-" << _minx << ", -" << _miny << ")" << std::endl;
+  Primitive::set_translation_min_values(_minx, _miny);
+  Surface::set_translation_min_values(_minx, _miny);
+  for (auto& obj : objects)
   {
-    MultiSurface* ms = new MultiSurface("");
-    ms->set_surface(sh);
-    o->add_primitive(ms);
+    GenericObject* o = new GenericObject(obj.id);
+    Surface* sh = new Surface("", tol_snap);
+    std::size_t i = 0;
+    while (i < obj.faces.size())
+    {
+      int n = obj.faces[i++];
+      std::vector<int> r(n);
+      for (int k = 0; k < n; k++) {
+        std::size_t vi = 3 * std::size_t(obj.faces[i++]);
+        Point3 p(vertices[vi] - _minx, vertices[vi + 1] - _miny, vertices[vi + 2]);
+        r[k] = sh->add_point(p);
+      }
+      std::vector< std::vector<int> > pgnids;
+      pgnids.push_back(r);
+      sh->add_face(pgnids);
+    }
+    if (prim3d == SOLID)
+    {
+      Solid* sol = new Solid("");
+      sol->set_oshell(sh);
+      o->add_primitive(sol);
+    }
+    else if ( prim3d == COMPOSITESURFACE)
+    {
+      CompositeSurface* cs = new CompositeSurface("");
+      cs->set_surface(sh);
+      o->add_primitive(cs);
+    }
+    else if (prim3d == MULTISURFACE)
+    {
+      MultiSurface* ms = new MultiSurface("");
+      ms->set_surface(sh);
+      o->add_primitive(ms);
+    }
+    lsFeatures.push_back(o);
   }
-  for (auto& each : allvertices)
-    delete each;
-  allvertices.clear();
-  lsFeatures.push_back(o);  
 }
 
 
@@ -1541,6 +2128,8 @@ void parse_tu3djson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap)
     std::string fid = "feature=" + std::to_string(fcounter);
     GenericObject* go = new GenericObject(std::to_string(fcounter));
     fcounter++;
+    std::vector<double> vertices;
+    decode_json_vertices(f["geometry"], vertices, false);
     if  (f["geometry"]["type"] == "Solid")
     {
       Solid* s = new Solid(fid);
@@ -1553,7 +2142,7 @@ void parse_tu3djson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap)
         no_shell++;
         for (auto& polygon : shell) { 
           std::vector< std::vector<int> > pa = polygon;
-          process_json_surface(pa, f["geometry"], sh);
+          process_json_surface(pa, vertices, sh);
         }
         if (oshell == true)
         {
@@ -1571,7 +2160,7 @@ void parse_tu3djson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap)
       for (auto& p : f["geometry"]["boundaries"]) 
       { 
         std::vector< std::vector<int> > pa = p;
-        process_json_surface(pa, f["geometry"], sh);
+        process_json_surface(pa, vertices, sh);
       }
       if (f["geometry"]["type"] == "MultiSurface")
       {
@@ -1603,7 +2192,7 @@ void parse_tu3djson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap)
           Surface* sh = new Surface(shid, tol_snap);
           for (auto& polygon : shell) { 
             std::vector< std::vector<int> > pa = polygon;
-            process_json_surface(pa, f["geometry"], sh);
+            process_json_surface(pa, vertices, sh);
           }
           if (oshell == true)
           {
@@ -1635,7 +2224,7 @@ void parse_tu3djson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap)
           Surface* sh = new Surface(shid, tol_snap);
           for (auto& polygon : shell) { 
             std::vector< std::vector<int> > pa = polygon;
-            process_json_surface(pa, f["geometry"], sh);
+            process_json_surface(pa, vertices, sh);
           }
           if (oshell == true)
           {
@@ -1660,6 +2249,8 @@ void parse_tu3djson_onegeom(json& j, std::vector<Feature*>& lsFeatures, double t
   //-- TODO: not translation for tu3djson, is that okay?
   set_min_xy(0.0, 0.0);
   GenericObject* go = new GenericObject("0");
+  std::vector<double> vertices;
+  decode_json_vertices(j, vertices, false);
   if  (j["type"] == "Solid")
   {
     Solid* s = new Solid();
@@ -1671,7 +2262,7 @@ void parse_tu3djson_onegeom(json& j, std::vector<Feature*>& lsFeatures, double t
       c++;
       for (auto& polygon : shell) { 
         std::vector< std::vector<int> > pa = polygon;
-        process_json_surface(pa, j, sh);
+        process_json_surface(pa, vertices, sh);
       }
       if (oshell == true)
       {
@@ -1689,7 +2280,7 @@ void parse_tu3djson_onegeom(json& j, std::vector<Feature*>& lsFeatures, double t
     for (auto& p : j["boundaries"]) 
     { 
       std::vector< std::vector<int> > pa = p;
-      process_json_surface(pa, j, sh);
+      process_json_surface(pa, vertices, sh);
     }
     if (j["type"] == "MultiSurface")
     {
@@ -1716,7 +2307,7 @@ void parse_tu3djson_onegeom(json& j, std::vector<Feature*>& lsFeatures, double t
         Surface* sh = new Surface(std::to_string(-1), tol_snap);
         for (auto& polygon : shell) { 
           std::vector< std::vector<int> > pa = polygon;
-          process_json_surface(pa, j, sh);
+          process_json_surface(pa, vertices, sh);
         }
         if (oshell == true)
         {
@@ -1742,7 +2333,7 @@ void parse_tu3djson_onegeom(json& j, std::vector<Feature*>& lsFeatures, double t
         Surface* sh = new Surface(std::to_string(-1), tol_snap);
         for (auto& polygon : shell) { 
           std::vector< std::vector<int> > pa = polygon;
-          process_json_surface(pa, j, sh);
+          process_json_surface(pa, vertices, sh);
         }
         if (oshell == true)
         {
@@ -1768,12 +2359,48 @@ json get_report_json(std::string ifile,
                      double planarity_d2p_tol,
                      double planarity_n_tol,
                      IOErrors ioerrs)
+{
+  ValidationSummary summary;
+  std::vector<json> lsReports;
+  for (auto& f : lsFeatures) {
+    summary.add_feature(f);
+    lsReports.push_back(f->get_report_json());
+  }
+  return get_report_json(ifile, summary, lsReports, val3dity_version, snap_tol, overlap_tol, planarity_d2p_tol, planarity_n_tol, ioerrs);
+}
+
+
+json get_report_json(std::string ifile, 
+                     ValidationSummary& summary,
+                     std::vector<json>& lsReports,
+                     std::string val3dity_version,
+                     double snap_tol,
+                     double overlap_tol,
+                     double planarity_d2p_tol,
+                     double planarity_n_tol,
+                     IOErrors ioerrs)
+{
+  json jr = get_report_json_header(ifile, val3dity_version, snap_tol, overlap_tol, planarity_d2p_tol, planarity_n_tol);
+  //-- each of the features with their primitives listed
+  jr["features"] = json::array();
+  for (auto& r : lsReports)
+    jr["features"].push_back(r);
+  jr.update(get_report_json_overview(summary, ioerrs));
+  return jr;
+}
+
+
+json get_report_json_header(std::string ifile,
+                            std::string val3dity_version,
+                            double snap_tol,
+                            double overlap_tol,
+                            double planarity_d2p_tol,
+                            double planarity_n_tol)
 {
   json jr;
   jr["type"] = "val3dity_report";
   jr["val3dity_version"] = val3dity_version; 
   jr["input_file"] = ifile;
-  jr["input_file_type"] = ioerrs.get_input_file_type();
   //-- time
   std::time_t currentTime;
   struct tm * localTime;
@@ -1788,25 +2415,18 @@ json get_report_json(std::string ifile,
   jr["parameters"]["overlap_tol"] = overlap_tol;
   jr["parameters"]["planarity_d2p_tol"] = planarity_d2p_tol;
   jr["parameters"]["planarity_n_tol"] = planarity_n_tol;
+  return jr;
+}
+
+
+json get_report_json_overview(ValidationSummary& summary, IOErrors& ioerrs)
+{
+  json jr;
+  jr["input_file_type"] = ioerrs.get_input_file_type();
 
   //-- primitives overview
-  std::map<int, std::tuple<int,int> > prim_o; //-- <primID, total, valid>
-  std::set<int> theprimitives;
-  for (auto& f : lsFeatures)
-    for (auto& p : f->get_primitives())
-      theprimitives.insert(p->get_type());
-  for (auto& each : theprimitives)
-    prim_o[each] = std::make_tuple(0, 0);
-  for (auto& f : lsFeatures) {
-    for (auto& p : f->get_primitives()) {
-      std::get<0>(prim_o[p->get_type()]) += 1;
-      if (p->is_valid() == true) {
-        std::get<1>(prim_o[p->get_type()]) += 1;
-      }
-    }
-  }
   jr["primitives_overview"] = json::array();
-  for (auto& each : prim_o) {
+  for (auto& each : summary.get_primitives_overview()) {
     json j;
     switch(each.first)
     {
@@ -1824,20 +2444,8 @@ json get_report_json(std::string ifile,
   }
 
   //-- features overview
-  std::map<std::string, std::tuple<int,int> > feat_o; //-- <featureID, total, valid>
-  std::set<std::string> thefeatures;
-  for (auto& f : lsFeatures)
-    thefeatures.insert(f->get_type());
-  for (auto& each : thefeatures)
-    feat_o[each] = std::make_tuple(0, 0);
-  for (auto& f : lsFeatures) {
-    std::get<0>(feat_o[f->get_type()]) += 1;
-    if (f->is_valid() == true) {
-      std::get<1>(feat_o[f->get_type()]) += 1;
-    }
-  }
   jr["features_overview"] = json::array();
-  for (auto& each : feat_o) {
+  for (auto& each : summary.get_features_overview()) {
     json j;
     j["type"] = each.first; 
     j["total"] = std::get<0>(each.second);
@@ -1845,34 +2453,21 @@ json get_report_json(std::string ifile,
     jr["features_overview"].push_back(j);
   }
 
-  //-- each of the features with their primitives listed
-  jr["features"] = json::array();
-  for (auto& f : lsFeatures)
-    jr["features"].push_back(f->get_report_json());
-  
   //-- dataset errors (9xx)
   jr["dataset_errors"] = json::array();
   if (ioerrs.has_errors() == true)
     jr["dataset_errors"] = ioerrs.get_report_json();
 
   //-- overview of errors
-  std::set<int> unique_errors;
-  for (auto& f : lsFeatures)
-    for (auto& code : f->get_unique_error_codes())
-      unique_errors.insert(code);
   jr["all_errors"] = json::array();
-  for (auto& e : unique_errors)
+  for (auto& e : summary.get_unique_error_codes())
     jr["all_errors"].push_back(e);
   for (auto& e : ioerrs.get_unique_error_codes())
     jr["all_errors"].push_back(e);
 
   bool bValid = true;
-  for (auto& f : lsFeatures) {
-    if (f->is_valid() == false) {
-      bValid = false;
-      break;
-    }
-  }
+  if (summary.number_features_valid() != summary.number_features())
+    bValid = false;
   if (ioerrs.has_errors() == true)
     bValid = false;
   jr["validity"] = bValid;
@@ -1881,4 +2476,92 @@ json get_report_json(std::string ifile,
 }
 
 
+//-- dump with indentation, shifted by 'shift' spaces to be nested in the report
+std::string dump_shifted(json& j, int shift)
+{
+  std::string pad(shift, ' ');
+  std::string s = j.dump(2);
+  std::string r = pad;
+  r.reserve(s.size() + pad.size());
+  for (auto& c : s)
+  {
+    r += c;
+    if (c == '\n')
+      r += pad;
+  }
+  return r;
+}
+
+
+bool ReportWriter::open(std::string ofile, 
+                        std::string ifile, 
+                        std::string val3dity_version, 
+                        double snap_tol, 
+                        double overlap_tol, 
+                        double planarity_d2p_tol, 
+                        double planarity_n_tol)
+{
+  json jh = get_report_json_header(ifile, val3dity_version, snap_tol, overlap_tol, planarity_d2p_tol, planarity_n_tol);
+  //-- the header without its closing "}", the features are written after it
+  _header = jh.dump(2);
+  _header = _header.substr(0, _header.find_last_of('}'));
+  while ( (_header.empty() == false) && (_header.back() == '\n') )
+    _header.pop_back();
+  _ofile = ofile;
+  return this->start();
+}
+
+
+bool ReportWriter::start()
+{
+  _out.open(_ofile, std::ofstream::out | std::ofstream::trunc);
+  if (!_out)
+    return false;
+  _out << _header << ",\n  \"features\": [";
+  _nofeatures = 0;
+  return true;
+}
+
+
+bool ReportWriter::is_open()
+{
+  return _out.is_open();
+}
+
+
+void ReportWriter::add_feature(json jf)
+{
+  if (_out.is_open() == false)
+    return;
+  if (_nofeatures > 0)
+    _out << ",";
+  _out << "\n" << dump_shifted(jf, 4);
+  _nofeatures++;
+}
+
+
+void ReportWriter::clear_features()
+{
+  if (_out.is_open() == false)
+    return;
+  _out.close();
+  this->start();
+}
+
+
+void ReportWriter::close(ValidationSummary& summary, IOErrors& ioerrs)
+{
+  if (_out.is_open() == false)
+    return;
+  if (_nofeatures > 0)
+    _out << "\n  ";
+  _out << "],\n";
+  json jo = get_report_json_overview(summary, ioerrs);
+  //-- the overview without its opening "{"
+  std::string s = jo.dump(2);
+  _out << s.substr(s.find_first_of('\n') + 1) << std::endl;
+  _out.close();
+}
+
+
 } // namespace val3dity
@@ -32,6 +32,8 @@
 #include "definitions.h"
 #include <fstream>
 #include <string>
+#include <functional>
+#include <unordered_map>
 #include "pugixml.hpp"
 #include "nlohmann/json.hpp"
 
@@ -68,6 +70,49 @@ public:
   void          set_input_file_type(std::string s);
 };
 
+
+//-- overview of the validation, updated one Feature at a time so that the
+//-- Features do not need to be kept in memory for the summary/report
+class ValidationSummary {
+  int                                         _nofeatures = 0;
+  int                                         _nofeatures_valid = 0;
+  int                                         _noprimitives = 0;
+  int                                         _noprimitives_valid = 0;
+  std::map<std::string, std::tuple<int,int> > _feat_o;   //-- <featuretype, total, valid>
+  std::map<int, std::tuple<int,int> >         _prim_o;   //-- <primtype, total, valid>
+  std::map<int, int>                          _errors_f; //-- <code (>600), # features>
+  std::map<int, int>                          _errors_p; //-- <code, # primitives>
+  std::set<int>                               _errors;
+public:
+  void          add_feature(Feature* f);
+  int           number_features();
+  int           number_features_valid();
+  int           number_primitives();
+  int           number_primitives_valid();
+  std::map<std::string, std::tuple<int,int> >& get_features_overview();
+  std::map<int, std::tuple<int,int> >&         get_primitives_overview();
+  std::map<int, int>&                          get_errors_features();
+  std::map<int, int>&                          get_errors_primitives();
+  std::set<int>&                               get_unique_error_codes();
+};
+
+
+//-- writes the JSON report incrementally: each Feature is written as soon as it's
+//-- validated, the overviews (with the running totals) are written when closing
+class ReportWriter {
+  std::ofstream   _out;
+  std::string     _ofile;
+  std::string     _header;
+  int             _nofeatures = 0;
+  bool            start();
+public:
+  bool          open(std::string ofile, std::string ifile, std::string val3dity_version, double snap_tol, double overlap_tol, double planarity_d2p_tol, double planarity_n_tol);
+  bool          is_open();
+  void          add_feature(json jf);
+  void          clear_features();
+  void          close(ValidationSummary& summary, IOErrors& ioerrs);
+};
+
   
 struct citygml_objects_walker: pugi::xml_tree_walker {
   std::vector<pugi::xml_node> lsNodes;
@@ -139,6 +184,32 @@ struct primitives_walker: pugi::xml_tree_walker
   }
 };
 
+//-- index of an IndoorGML document, built with one walk of the tree (see build_gml_index)
+struct GMLIndex
+{
+  struct Coords {
+    std::size_t start;  //-- first coordinate in 'coords'
+    std::size_t size;   //-- # of coordinates
+    bool        valid;  //-- false if the text has something else than numbers
+  };
+  std::map<std::string, pugi::xpath_node>    dallpoly;  //-- gml:id of Polygons and OrientableSurfaces
+  std::vector<pugi::xml_node>                xlinks;    //-- surfaceMembers with an xlink:href
+  std::unordered_map<std::size_t, Coords>    dcoords;   //-- <gml:pos> and <gml:posList> (key: node.hash_value())
+  std::vector<double>                        coords;    //-- all the coordinates, parsed only once
+  double                                     minx = 9e15;
+  double                                     miny = 9e15;
+  bool          get_coords(const pugi::xml_node& n, const double*& c, std::size_t& size);
+};
+
+struct gml_index_walker: pugi::xml_tree_walker
+{
+  GMLIndex& index;
+  std::string spolygon, sosurface, ssurfacemember, spos, sposlist, sgmlid, shref;
+  gml_index_walker(GMLIndex& i) : index(i) {}
+  virtual bool begin(pugi::xml_node& node);
+  virtual bool for_each(pugi::xml_node& node);
+};
+
 struct semantic_surfaces_walker: pugi::xml_tree_walker {
   std::vector<pugi::xml_node> lsNodes;
   virtual bool for_each(pugi::xml_node &node) 
@@ -160,46 +231,54 @@ void              read_file_gml(std::string &ifile, std::vector<Feature*>& lsFea
 std::map<std::string, std::string> 
                   get_namespaces(pugi::xml_node& root);
 
-void              read_file_json(std::string &ifile, std::vector<Feature*>& lsFeatures, IOErrors& errs, double tol_snap);
-void              read_file_cjseq(std::string &ifile, std::vector<Feature*>& lsFeatures, IOErrors& errs, double tol_snap);
+void              read_file_json(std::string &ifile, std::vector<Feature*>& lsFeatures, std::vector<GeometryTemplate*>& lsGTs, IOErrors& errs, double tol_snap);
+void              read_file_cjseq(std::string &ifile, std::vector<Feature*>& lsFeatures, std::vector<GeometryTemplate*>& lsGTs, IOErrors& errs, double tol_snap);
+void              read_file_cjseq_parallel(std::string &ifile, IOErrors& errs, double tol_snap, int jobs, std::function<void(Feature*)> validate, std::function<void(Feature*)> process);
+void              read_file_json_stream(std::string &ifile, IOErrors& errs, double tol_snap, std::function<void(Feature*, int)> process);
 
-void              parse_obj(std::istream &input, std::vector<Feature*>& lsFeatures, Primitive3D prim3d, IOErrors& errs, double tol_snap);
-Surface*          parse_poly(std::istream &input, int shellid, IOErrors& errs);
-Surface*          parse_off(std::istream &input, int shellid, IOErrors& errs, double tol_snap);
+void              parse_obj(const char* buf, std::size_t len, std::vector<Feature*>& lsFeatures, Primitive3D prim3d, IOErrors& errs, double tol_snap);
+Surface*          parse_poly(const char* buf, std::size_t len, int shellid, IOErrors& errs);
+Surface*          parse_off(const char* buf, std::size_t len, int shellid, IOErrors& errs, double tol_snap);
 
-void              parse_cityjson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap);
+void              parse_cityjson(json& j, std::vector<Feature*>& lsFeatures, std::vector<GeometryTemplate*>& lsGTs, double tol_snap);
 void              parse_cjseq(json& j, std::vector<Feature*>& lsFeatures, double tol_snap, std::vector<GeometryTemplate*>& lsGTs);
 void              parse_tu3djson(json& j, std::vector<Feature*>& lsFeatures, double tol_snap);
 void              parse_tu3djson_onegeom(json& j, std::vector<Feature*>& lsFeatures, double tol_snap);
 void              parse_jsonfg(json& j, std::vector<Feature*>& lsFeatures, double tol_snap, IOErrors& errs);
 void              parse_jsonfg_onefeature(json& j, std::vector<Feature*>& lsFeatures, double tol_snap, int counter, IOErrors& errs);
 
-std::vector<int>  process_gml_ring(const pugi::xml_node& n, Surface* sh, IOErrors& errs);
-Surface*          process_gml_surface(const pugi::xml_node& n, int id, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs);
-MultiSurface*     process_gml_multisurface(const pugi::xml_node& nms, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs);
-CompositeSurface* process_gml_compositesurface(const pugi::xml_node& nms, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs);
-Solid*            process_gml_solid(const pugi::xml_node& nsolid, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs);
-MultiSolid*       process_gml_multisolid(const pugi::xml_node& nms, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs);
-CompositeSolid*   process_gml_compositesolid(const pugi::xml_node& nms, std::map<std::string, pugi::xpath_node>& dallpoly, double tol_snap, IOErrors& errs);
+std::vector<int>  process_gml_ring(const pugi::xml_node& n, Surface* sh, GMLIndex& gmlindex, IOErrors& errs);
+Surface*          process_gml_surface(const pugi::xml_node& n, int id, GMLIndex& gmlindex, double tol_snap, IOErrors& errs);
+MultiSurface*     process_gml_multisurface(const pugi::xml_node& nms, GMLIndex& gmlindex, double tol_snap, IOErrors& errs);
+CompositeSurface* process_gml_compositesurface(const pugi::xml_node& nms, GMLIndex& gmlindex, double tol_snap, IOErrors& errs);
+Solid*            process_gml_solid(const pugi::xml_node& nsolid, GMLIndex& gmlindex, double tol_snap, IOErrors& errs);
+MultiSolid*       process_gml_multisolid(const pugi::xml_node& nms, GMLIndex& gmlindex, double tol_snap, IOErrors& errs);
+CompositeSolid*   process_gml_compositesolid(const pugi::xml_node& nms, GMLIndex& gmlindex, double tol_snap, IOErrors& errs);
 
 
-void              process_json_geometries_of_co(json& jco, CityObject* co, std::string coid, std::vector<GeometryTemplate*>& lsGTs, json& j, double tol_snap);
-void              process_json_surface(std::vector< std::vector<int> >& pgn, nlohmann::json& j, Surface* s);
+void              process_json_geometries_of_co(json& jco, CityObject* co, std::string coid, std::vector<GeometryTemplate*>& lsGTs, const std::vector<double>& vertices, double tol_snap);
+void              process_json_surface(std::vector< std::vector<int> >& pgn, const std::vector<double>& vertices, Surface* s);
+void              decode_json_vertices(json& j, std::vector<double>& vertices, bool update_min_xy);
+void              apply_json_transform(std::vector<double>& vertices, json& jtransform);
 void              process_jsonfg_surface(std::vector< std::vector<int> >& pgn, Surface* s, IOErrors& errs);
 void              process_cityjson_geometrytemplates(json& jgt, std::vector<GeometryTemplate*>& lsGTs, double tol_snap);
-void              process_json_surface_geometrytemplate(std::vector< std::vector<int> >& pgn, json& j, Surface* sh);
-void              build_dico_xlinks(pugi::xml_document& doc, std::map<std::string, pugi::xpath_node>& dallpoly, IOErrors& errs);
-void              process_gml_file_indoorgml(pugi::xml_document& doc, std::vector<Feature*>& lsFeatures, std::map<std::string, pugi::xpath_node>& dallpoly, IOErrors& errs, double tol_snap);
+void              process_json_surface_geometrytemplate(std::vector< std::vector<int> >& pgn, const std::vector<double>& vertices, Surface* sh);
+void              build_gml_index(pugi::xml_document& doc, GMLIndex& gmlindex, IOErrors& errs);
+void              process_gml_file_indoorgml(pugi::xml_document& doc, std::vector<Feature*>& lsFeatures, GMLIndex& gmlindex, IOErrors& errs, double tol_snap);
 
 void              printProgressBar(int percent);
 std::string       localise(std::string s);
 std::string       remove_xml_namespace(const char* input);
 
 void              set_min_xy(double minx, double miny);
-void              compute_min_xy(pugi::xml_document& doc);
-void              compute_min_xy(json& j);
+void              set_min_xy_cjseq(json& jtransform);
+void              compute_min_xy(const std::vector<double>& vertices);
 
 json              get_report_json(std::string ifile, std::vector<Feature*>& lsFeatures, std::string val3dity_version, double snap_tol, double overlap_tol, double planarity_d2p_tol, double planarity_n_tol, IOErrors ioerrs);
+json              get_report_json_header(std::string ifile, std::string val3dity_version, double snap_tol, double overlap_tol, double planarity_d2p_tol, double planarity_n_tol);
+json              get_report_json_overview(ValidationSummary& summary, IOErrors& ioerrs);
+std::string       dump_shifted(json& j, int shift);
+json              get_report_json(std::string ifile, ValidationSummary& summary, std::vector<json>& lsReports, std::string val3dity_version, double snap_tol, double overlap_tol, double planarity_d2p_tol, double planarity_n_tol, IOErrors ioerrs);
 
 } // namespace val3dity
 
@@ -32,9 +32,14 @@
 #include "MultiSurface.h"
 #include "CompositeSurface.h"
 #include "Solid.h"
+#include "CompositeSolid.h"
 #include "Feature.h"
 
 #include "GenericObject.h"
+#include "GeometryTemplate.h"
+#include "pipeline.h"
+#include "validate_prim_toporel.h"
+#include "textinput.h"
 
 #include <tclap/CmdLine.h>
 #include <time.h>  
@@ -51,13 +56,21 @@ using json = nlohmann::json;
 std::string VAL3DITY_VERSION = "2.5.1";
 
 
-std::string print_summary_validation(std::vector<Feature*>& lsFeatures, IOErrors& ioerrs);
-std::string unit_test(std::vector<Feature*>& lsFeatures, IOErrors& ioerrs);
-void        write_report_json(json& jr, std::string report);
+std::string print_summary_validation(ValidationSummary& summary, IOErrors& ioerrs);
+std::string unit_test(ValidationSummary& summary, IOErrors& ioerrs);
+std::string get_report_path(std::string report);
+std::string validate_cjseq_feature(json& j, 
+                                   json& jtransform, 
+                                   std::vector<GeometryTemplate*>& lsGTs, 
+                                   double tol_snap, 
+                                   double tol_planarity_d2p, 
+                                   double tol_planarity_n, 
+                                   double tol_overlap);
 void        read_stream_cjseq(double tol_snap, 
                               double tol_planarity_d2p, 
                               double tol_planarity_normals, 
-                              double tol_overlap);
+                              double tol_overlap,
+                              int jobs);
 
 
 
@@ -235,6 +248,18 @@ int main(int argc, char* const argv[])
                                               "ignore204",
                                               "ignore error 204",
                                               false);    
+    TCLAP::SwitchArg                        geos("",
+                                              "geos",
+                                              "use GEOS for the 2D validation of the surfaces (slower, as reference)",
+                                              false);
+    TCLAP::SwitchArg                        corefinement("",
+                                              "corefinement",
+                                              "use the corefinement of triangle meshes (instead of Nef polyhedra) to test the overlap of the solids of a CompositeSolid",
+                                              false);
+    TCLAP::SwitchArg                        overlap_distance("",
+                                              "overlap_distance",
+                                              "use distances between triangle meshes (instead of Minkowski sums of Nef polyhedra) for the tolerance of --overlap_tol",
+                                              false);
     TCLAP::ValueArg<std::string>            output_off("",
                                               "output_off",
                                               "output each shell/surface in OFF format",
@@ -259,6 +284,28 @@ int main(int argc, char* const argv[])
                                               false,
                                               0.01,
                                               "double");
+    TCLAP::SwitchArg                        stream("",
+                                              "stream",
+                                              "read a CityJSON file one City Object at a time (bounded memory, for large files)",
+                                              false);
+    TCLAP::ValueArg<int>                    jobs("j",
+                                              "jobs",
+                                              "number of threads used to validate a CityJSONSeq file (default=1)",
+                                              false,
+                                              1,
+                                              "int");
+    TCLAP::ValueArg<int>                    si_threads("",
+                                              "si_threads",
+                                              "number of threads used to test the self-intersections of large shells, if compiled with TBB (default=0: all cores)",
+                                              false,
+                                              0,
+                                              "int");
+    TCLAP::ValueArg<int>                    overlap_threads("",
+                                              "overlap_threads",
+                                              "number of threads used to test the overlap of the BuildingParts/solids of a feature, if CGAL is compiled with threads support (default=1, 0: all cores)",
+                                              false,
+                                              1,
+                                              "int");
     TCLAP::ValueArg<double>                 planarity_n_tol("",
                                               "planarity_n_tol",
                                               "tolerance for planarity based on normals deviation (default=20.0degree)",
@@ -273,7 +320,14 @@ int main(int argc, char* const argv[])
     cmd.add(verbose);
     cmd.add(primitives);
     cmd.add(ignore204);
+    cmd.add(geos);
+    cmd.add(corefinement);
+    cmd.add(overlap_distance);
     cmd.add(unittests);
+    cmd.add(stream);
+    cmd.add(jobs);
+    cmd.add(si_threads);
+    cmd.add(overlap_threads);
     cmd.add(output_off);
     cmd.add(inputfile);
     cmd.add(listerrors);
@@ -285,17 +339,25 @@ int main(int argc, char* const argv[])
     //-- vector with Features: CityObject, GenericObject, 
     //-- or IndoorModel (or others in the future)
     std::vector<Feature*> lsFeatures;
+    //-- the GeometryTemplates are shared by the Features, they are freed at the end
+    std::vector<GeometryTemplate*> lsGTs;
     
     //-- if verbose == false then log to a file
     if (verbose.getValue() == false)
     {
       spdlog::set_level(spdlog::level::off);
     }
+    Surface::set_validation_2d_with_geos(geos.getValue());
+    Surface::set_self_intersection_threads(si_threads.getValue());
+    CompositeSolid::set_overlap_with_corefinement(corefinement.getValue());
+    //-- with --jobs the features are already validated in parallel
+    set_overlap_threads( (jobs.getValue() > 1) ? 1 : overlap_threads.getValue() );
+    set_overlap_tol_with_distances(overlap_distance.getValue());
 
     InputTypes inputtype = OTHER;
     if ( (inputfile.getValue() == "stdin") || (inputfile.getValue() == "STDIN") ) {
       inputtype = STDIN;
-      read_stream_cjseq(snap_tol.getValue(), planarity_d2p_tol.getValue(), planarity_n_tol.getValue(), overlap_tol.getValue());
+      read_stream_cjseq(snap_tol.getValue(), planarity_d2p_tol.getValue(), planarity_n_tol.getValue(), overlap_tol.getValue(), jobs.getValue());
       return(0);
     } else {
       std::string extension = inputfile.getValue().substr(inputfile.getValue().find_last_of(".") + 1);
@@ -390,10 +452,22 @@ int main(int argc, char* const argv[])
             ioerrs.add_error(901, "Invalid GML structure, or that particular construction of GML is not supported. Please report at https://github.com/tudelft3d/val3dity/issues and provide the file.");
         }
       }
+      else if ( (inputtype == JSON) && (stream.getValue() == true) )
+      {
+        //-- the file is read during the validation, one CityObject at a time
+        if (output_off.getValue() != "")
+          ioerrs.add_error(903, "OFF output not possible when the file is streamed (option '--stream')");
+        if (ishellfiles.getValue().size() > 0)
+        {
+          std::cout << "No inner shells allowed when JSON file used as input." << std::endl;
+          ioerrs.add_error(901, "No inner shells allowed when JSON file used as input.");
+        }
+      }
       else if (inputtype == JSON)
       {
         read_file_json(inputfile.getValue(), 
                        lsFeatures,
+                       lsGTs,
                        ioerrs, 
                        snap_tol.getValue());
         if (ioerrs.has_errors() == true) {
@@ -406,10 +480,22 @@ int main(int argc, char* const argv[])
           ioerrs.add_error(901, "No inner shells allowed when JSON file used as input.");
         }
       }
+      else if ( (inputtype == JSONL) && (jobs.getValue() > 1) )
+      {
+        //-- the file is read during the validation, by several threads
+        if (output_off.getValue() != "")
+          ioerrs.add_error(903, "OFF output not possible when several threads are used (option '--jobs')");
+        if (ishellfiles.getValue().size() > 0)
+        {
+          std::cout << "No inner shells allowed when JSONL file used as input." << std::endl;
+          ioerrs.add_error(901, "No inner shells allowed when JSONL file used as input.");
+        }
+      }
       else if (inputtype == JSONL)
       {
         read_file_cjseq(inputfile.getValue(), 
                         lsFeatures,
+                        lsGTs,
                         ioerrs, 
                         snap_tol.getValue());
         if (ioerrs.has_errors() == true) {
@@ -425,12 +511,12 @@ int main(int argc, char* const argv[])
       else if (inputtype == POLY)
       {
         std::cout << "Reading file: " << inputfile.getValue() << std::endl;
-        std::ifstream infile(inputfile.getValue().c_str(), std::ifstream::in);
-        if (!infile) {
+        MappedFile infile;
+        if (infile.open(inputfile.getValue()) == false) {
           ioerrs.add_error(901, "Input file not found.");
         } else {
           GenericObject* o = new GenericObject("none");
-          Surface* sh = parse_poly(infile, 0, ioerrs);
+          Surface* sh = parse_poly(infile.data(), infile.size(), 0, ioerrs);
           if ( (ioerrs.has_errors() == false) & (prim3d == SOLID) )
           {
             Solid* s = new Solid();
@@ -438,8 +524,12 @@ int main(int argc, char* const argv[])
             int sid = 1;
             for (auto ifile : ishellfiles.getValue())
             {
-              std::ifstream if2(ifile.c_str(), std::ifstream::in);
-              Surface* sh = parse_poly(if2, sid, ioerrs);
+              MappedFile if2;
+              if (if2.open(ifile) == false) {
+                ioerrs.add_error(901, "Input file not found: " + ifile);
+                break;
+              }
+              Surface* sh = parse_poly(if2.data(), if2.size(), sid, ioerrs);
               if (ioerrs.has_errors() == false)
               {
                 s->add_ishell(sh);
@@ -469,12 +559,12 @@ int main(int argc, char* const argv[])
       else if (inputtype == OFF)
       {
         std::cout << "Reading file: " << inputfile.getValue() << std::endl;
-        std::ifstream infile(inputfile.getValue().c_str(), std::ifstream::in);
-        if (!infile) {
+        MappedFile infile;
+        if (infile.open(inputfile.getValue()) == false) {
           ioerrs.add_error(901, "Input file not found.");
         } else {
           GenericObject* o = new GenericObject("none");
-          Surface* sh = parse_off(infile, 0, ioerrs, snap_tol.getValue());
+          Surface* sh = parse_off(infile.data(), infile.size(), 0, ioerrs, snap_tol.getValue());
           if ( (ioerrs.has_errors() == false) & (prim3d == SOLID) )
           {
             Solid* s = new Solid;
@@ -502,11 +592,11 @@ int main(int argc, char* const argv[])
       else if (inputtype == OBJ)
       {
         std::cout << "Reading file: " << inputfile.getValue() << std::endl;
-        std::ifstream infile(inputfile.getValue().c_str(), std::ifstream::in);
-        if (!infile) {
+        MappedFile infile;
+        if (infile.open(inputfile.getValue()) == false) {
           ioerrs.add_error(901, "Input file not found.");
         } else {
-          parse_obj(infile, lsFeatures, prim3d, ioerrs, snap_tol.getValue());
+          parse_obj(infile.data(), infile.size(), lsFeatures, prim3d, ioerrs, snap_tol.getValue());
           if (ioerrs.has_errors() == true) {
             std::cout << "Errors while reading the input file, aborting." << std::endl;
             std::cout << ioerrs.get_report_text() << std::endl;
@@ -540,7 +630,74 @@ int main(int argc, char* const argv[])
       std::cout << std::endl;
     }
     
+    //-- the report is written while validating, one Feature at a time
+    ReportWriter reportwriter;
+    std::string reportpath = "";
+    if (report.getValue() != "")
+    {
+      string of = inputfile.getValue();
+      if (boost::filesystem::exists(inputfile.getValue()))
+        of = boost::filesystem::canonical(inputfile.getValue()).string();
+      reportpath = get_report_path(report.getValue());
+      if (reportpath != "")
+        reportwriter.open(reportpath,
+                          of,
+                          VAL3DITY_VERSION,
+                          snap_tol.getValue(),
+                          overlap_tol.getValue(),
+                          planarity_d2p_tol.getValue(),
+                          planarity_n_tol_updated);
+    }
+
     //-- now the validation starts
+    ValidationSummary summary;
+    //-- each Feature is added to the summary/report as soon as it is validated (and
+    //-- for --stream and --jobs it's then deleted)
+    auto add_feature = [&](Feature* f) {
+      summary.add_feature(f);
+      if (reportwriter.is_open() == true)
+        reportwriter.add_feature(f->get_report_json());
+    };
+    auto collect_feature = [&](Feature* f) {
+      add_feature(f);
+      delete f;
+    };
+    bool readduringvalidation = false;
+    if ( (inputtype == JSON) && (stream.getValue() == true) && (ioerrs.has_errors() == false) )
+    {
+      readduringvalidation = true;
+      int i = 1;
+      read_file_json_stream(inputfile.getValue(), 
+                            ioerrs, 
+                            snap_tol.getValue(),
+                            [&](Feature* f, int nofeatures) {
+        if ( (i % 10 == 0) && (verbose.getValue() == false) )
+          printProgressBar(100 * (i / double(nofeatures)));
+        i++;
+        f->validate(planarity_d2p_tol.getValue(), planarity_n_tol_updated, overlap_tol.getValue());
+        collect_feature(f);
+      });
+      if ( (i > 1) && (verbose.getValue() == false) )
+        printProgressBar(100);
+    }
+    else if ( (inputtype == JSONL) && (jobs.getValue() > 1) && (ioerrs.has_errors() == false) )
+    {
+      readduringvalidation = true;
+      read_file_cjseq_parallel(inputfile.getValue(), 
+                               ioerrs, 
+                               snap_tol.getValue(),
+                               jobs.getValue(),
+                               [&](Feature* f) {
+        f->validate(planarity_d2p_tol.getValue(), planarity_n_tol_updated, overlap_tol.getValue());
+      },
+                               collect_feature);
+      std::cout << "Validation of " << summary.number_features() << " feature(s)" << std::endl;
+    }
+    if ( (readduringvalidation == true) && (ioerrs.has_errors() == true) )
+    {
+      std::cout << "Errors while reading the input file, aborting." << std::endl;
+      std::cout << ioerrs.get_report_text() << std::endl;
+    }
     if ( (lsFeatures.empty() == false) && (ioerrs.has_errors() == false) )
     {
       int i = 1;
@@ -551,6 +708,9 @@ int main(int argc, char* const argv[])
           printProgressBar(100 * (i / double(lsFeatures.size())));
         i++;
         f->validate(planarity_d2p_tol.getValue(), planarity_n_tol_updated, overlap_tol.getValue());
+        add_feature(f);
+        //-- the features are kept until the end (for the OFF output), not their Nef polyhedra
+        f->release_nef_polyhedra();
       }
       if (verbose.getValue() == false)
         printProgressBar(100);
@@ -560,11 +720,15 @@ int main(int argc, char* const argv[])
     //-- and is confusing for users to see a valid/invalid while nothing was done...
     if (ioerrs.has_specific_error(901) == true) {
       // std::cout << "ERROR 901" << std::endl;
+      for (auto& f : lsFeatures)
+        delete f;
       lsFeatures.clear();
+      summary = ValidationSummary();
+      reportwriter.clear_features();
     }
 
     //-- summary of the validation
-    std::cout << "\n" << print_summary_validation(lsFeatures, ioerrs) << std::endl;        
+    std::cout << "\n" << print_summary_validation(summary, ioerrs) << std::endl;        
 
     //-- output shells/surfaces in OFF format
     if (output_off.getValue() != "") 
@@ -625,28 +789,25 @@ int main(int argc, char* const argv[])
     //-- output report in JSON 
     if (report.getValue() != "") 
     {
-      string of = inputfile.getValue();
-      if (boost::filesystem::exists(inputfile.getValue()))
-        of = boost::filesystem::canonical(inputfile.getValue()).string();
-      //-- save the json report in memory first
-      json jr = get_report_json(of,
-                                lsFeatures,
-                                VAL3DITY_VERSION,
-                                snap_tol.getValue(),
-                                overlap_tol.getValue(),
-                                planarity_d2p_tol.getValue(),
-                                planarity_n_tol_updated,
-                                ioerrs);
-      if (report.getValue() != "")
-        write_report_json(jr, report.getValue());
+      if (reportwriter.is_open() == true)
+      {
+        reportwriter.close(summary, ioerrs);
+        std::cout << "Validation report saved to " << boost::filesystem::canonical(reportpath) << std::endl;
+        std::cout << "Browse its content:" << std::endl;
+        std::cout << "==>http://geovalidation.bk.tudelft.nl/val3dity/browser/\n" << std::endl;
+      }
     }
     else
       std::cout << "==> The validation report wasn't saved, use option '--report'." << std::endl;
 
     //-- unittests 
     if (unittests.getValue() == true)
-      std::cout << "\n" << unit_test(lsFeatures, ioerrs) << std::endl;
+      std::cout << "\n" << unit_test(summary, ioerrs) << std::endl;
 
+    for (auto& f : lsFeatures)
+      delete f;
+    for (auto& gt : lsGTs)
+      delete gt;
     return(0);
   }
   catch (TCLAP::ArgException &e) 
@@ -656,8 +817,36 @@ int main(int argc, char* const argv[])
   }
 }
 
-void read_stream_cjseq(double tol_snap, double tol_planarity_d2p, double tol_planarity_n, double tol_overlap = -1) {
+//-- validates one CityJSONFeature, returns its line for the output: "id" [codes]
+std::string validate_cjseq_feature(json& j, json& jtransform, std::vector<GeometryTemplate*>& lsGTs, double tol_snap, double tol_planarity_d2p, double tol_planarity_n, double tol_overlap) {
   std::vector<Feature*> lsFeatures;
+  j["transform"] = jtransform; //-- add transform b/c BuildingPart overlap uses a tolerance
+  json j_set = json::array();
+  try
+  {
+    parse_cjseq(j, lsFeatures, tol_snap, lsGTs);
+  }
+  catch (const json::exception& e)
+  {
+    //-- the structure of the CityJSONFeature is wrong
+    for (auto& f : lsFeatures)
+      delete f;
+    lsFeatures.clear();
+    j_set.push_back(901);
+  }
+  if (lsFeatures.empty() == false) {
+    auto f = lsFeatures[0];
+    f->validate(tol_planarity_d2p, tol_planarity_n, tol_overlap);
+    j_set = f->get_unique_error_codes();
+  }
+  for (auto& f : lsFeatures)
+    delete f;
+  std::stringstream ss;
+  ss << j["id"] << " " << j_set;
+  return ss.str();
+}
+
+void read_stream_cjseq(double tol_snap, double tol_planarity_d2p, double tol_planarity_n, double tol_overlap, int jobs) {
   //-- read and store the GeometryTemplates
   std::vector<GeometryTemplate*> lsGTs;
   //-- transform
@@ -674,6 +863,8 @@ void read_stream_cjseq(double tol_snap, double tol_planarity_d2p, double tol_pla
     catch (nlohmann::detail::parse_error e) 
     {
       std::cout << "line."  << linecount << " [905]" << std::endl;
+      linecount++;
+      continue;
     }
     //-- first line/metadata
     if (j["type"] == "CityJSON") {
@@ -691,53 +882,80 @@ void read_stream_cjseq(double tol_snap, double tol_planarity_d2p, double tol_pla
         break;
       } else {
         jtransform = j["transform"];
+        set_min_xy_cjseq(jtransform);
         std::cout << "\"\" []" << std::endl;
       }
     //-- all the other lines
     } else if (j["type"] == "CityJSONFeature") {
-      j["transform"] = jtransform; //-- add transform b/c BuildingPart overlap uses a tolerance
-      parse_cjseq(j, lsFeatures, tol_snap, lsGTs);
-      auto f = lsFeatures[0];
-      f->validate(tol_planarity_d2p, tol_planarity_n, tol_overlap);
-      json j_set(f->get_unique_error_codes());
-      std::cout << j["id"] << " ";
-      std::cout << j_set << std::endl;
-      delete f; 
-      lsFeatures.clear();
+      std::cout << validate_cjseq_feature(j, jtransform, lsGTs, tol_snap, tol_planarity_d2p, tol_planarity_n, tol_overlap) << std::endl;
     } else {
       std::cout << j["id"] << " [905]" << std::endl;
     }
     linecount++;
+    //-- once the 1st line is read, the others can be validated in parallel
+    if ( (jobs > 1) && (jtransform.is_null() == false) )
+      break;
+  }
+  if ( (jobs > 1) && (jtransform.is_null() == false) ) {
+    //-- each worker returns the output of its line, they are printed in the same 
+    //-- order as the input (max 16 lines per thread are waiting in memory)
+    process_lines_in_parallel<std::string>(std::cin, jobs, 16 * jobs,
+      [&](std::string& l) {
+        json j;
+        try 
+        {
+          j = json::parse(l);
+        }
+        catch (nlohmann::detail::parse_error e) 
+        {
+          return std::string(); //-- the line number is known only by the collector
+        }
+        if (j["type"] == "CityJSONFeature")
+          return validate_cjseq_feature(j, jtransform, lsGTs, tol_snap, tol_planarity_d2p, tol_planarity_n, tol_overlap);
+        std::stringstream ss;
+        ss << j["id"] << " [905]";
+        return ss.str();
+      },
+      [&](std::string& l, const std::exception& e) {
+        return std::string(); //-- not a JSON object
+      },
+      [&](std::string& out) {
+        if (out.empty() == true)
+          std::cout << "line."  << linecount << " [905]" << std::endl;
+        else
+          std::cout << out << std::endl;
+        linecount++;
+        return true;
+      });
   }
   if (linecount < 2) {
     std::string s = "CityJSONSeq has only the 1st line, and no CityJSONFeature.";
     std::cout << "ERROR: " << s << std::endl;
   }
+  for (auto& gt : lsGTs)
+    delete gt;
 }
 
-void write_report_json(json& jr, std::string report)
+//-- path of the report (with ".json" extension), "" if impossible to create
+std::string get_report_path(std::string report)
 {
   boost::filesystem::path outpath(report);
   if (boost::filesystem::exists(outpath.parent_path()) == false) {
     boost::filesystem::path fullpath(boost::filesystem::current_path() / report);
     if (boost::filesystem::exists(fullpath.parent_path()) == false) {
       std::cout << "Error: file " << outpath << " impossible to create, wrong path." << std::endl;
-      return;
+      return "";
     }
     else
       outpath = fullpath;
   }
   if (outpath.extension() != ".json")
     outpath += ".json";
-  std::ofstream o(outpath.string());
-  o << jr.dump(2) << std::endl;                                
-  std::cout << "Validation report saved to " << boost::filesystem::canonical(outpath) << std::endl;
-  std::cout << "Browse its content:" << std::endl;
-  std::cout << "==>http://geovalidation.bk.tudelft.nl/val3dity/browser/\n" << std::endl;
+  return outpath.string();
 }
 
 
-std::string unit_test(std::vector<Feature*>& lsFeatures, IOErrors& ioerrs)
+std::string unit_test(ValidationSummary& summary, IOErrors& ioerrs)
 {
   std::stringstream ss;
   ss << std::endl;
@@ -747,13 +965,8 @@ std::string unit_test(std::vector<Feature*>& lsFeatures, IOErrors& ioerrs)
     for (auto& each : ioerrs.get_unique_error_codes())
       theerrors.insert(each);
   }
-  for (auto& f : lsFeatures) {
-    for (auto& code : f->get_unique_error_codes())
-        theerrors.insert(code);
-    for (auto& p : f->get_primitives())
-      for (auto& code : p->get_unique_error_codes())
-        theerrors.insert(code);
-  }
+  for (auto& code : summary.get_unique_error_codes())
+    theerrors.insert(code);
   if (theerrors.size() > 0)
   {
     ss << "@INVALID ";
@@ -768,33 +981,15 @@ std::string unit_test(std::vector<Feature*>& lsFeatures, IOErrors& ioerrs)
 }
 
 
-std::string print_summary_validation(std::vector<Feature*>& lsFeatures, IOErrors& ioerrs)
+std::string print_summary_validation(ValidationSummary& summary, IOErrors& ioerrs)
 {
   std::stringstream ss;
   ss << std::endl;
-  int noprim = 0;
-  for (auto& o : lsFeatures)
-    for (auto& p : o->get_primitives())
-      noprim++;
+  int noprim = summary.number_primitives();
+  int nofeat = summary.number_features();
   //-- overview of errors
-  std::map<int,int> errors_f; //-- features
-  for (auto& f : lsFeatures)
-    for (auto& code : f->get_unique_error_codes())
-      if (code > 600)
-        errors_f[code] = 0;
-  for (auto& f : lsFeatures)
-    for (auto& code : f->get_unique_error_codes())
-      if (code > 600)
-        errors_f[code] += 1;
-  std::map<int,int> errors_p; //-- primitives
-  for (auto& f : lsFeatures)
-    for (auto& p : f->get_primitives())
-      for (auto& code : p->get_unique_error_codes())
-        errors_p[code] = 0;
-  for (auto& f : lsFeatures)
-    for (auto& p : f->get_primitives())
-      for (auto& code : p->get_unique_error_codes())
-        errors_p[code] += 1;
+  std::map<int,int>& errors_f = summary.get_errors_features(); //-- features
+  std::map<int,int>& errors_p = summary.get_errors_primitives(); //-- primitives
 
   ss << "+++++++++++++++++++ SUMMARY +++++++++++++++++++" << std::endl;
   if ( (errors_f.size() > 0) || (errors_p.size() > 0) || (ioerrs.has_errors() == true) )
@@ -806,41 +1001,29 @@ std::string print_summary_validation(std::vector<Feature*>& lsFeatures, IOErrors
   std::string ft = ioerrs.get_input_file_type();
   ss << "  " << ft << std::endl;
   ss << "+++++" << std::endl;
-  int fInvalid = 0;
-  for (auto& f : lsFeatures)
-  {
-    if (f->is_valid() == false)
-      fInvalid++;
-  }
-  ss << "Total # of Features: " << setw(10) << lsFeatures.size() << std::endl;
+  int fInvalid = nofeat - summary.number_features_valid();
+  ss << "Total # of Features: " << setw(10) << nofeat << std::endl;
   float percentage;
-  if (lsFeatures.size() == 0)
+  if (nofeat == 0)
     percentage = 0;
   else
-    percentage = 100 * (fInvalid / float(lsFeatures.size()));
-  ss << "  # valid: " << setw(20) << lsFeatures.size() - fInvalid;
-  if (lsFeatures.size() == 0)
+    percentage = 100 * (fInvalid / float(nofeat));
+  ss << "  # valid: " << setw(20) << nofeat - fInvalid;
+  if (nofeat == 0)
     ss << " (" << 0 << "%)" << std::endl;
   else
     ss << std::fixed << setprecision(1) << " (" << 100 - percentage << "%)" << std::endl;
   ss << "  # invalid: " << setw(18) << fInvalid;
   ss << std::fixed << setprecision(1) << " (" << percentage << "%)" << std::endl;
-  std::set<std::string> thetypes;
-  for (auto& f : lsFeatures)
-    thetypes.insert(f->get_type());
-  if (thetypes.empty() == false)
+  if (summary.get_features_overview().empty() == false)
   {
     ss << "Types:" << std::endl;
-    for (auto& each : thetypes)
-      ss << "  " << each << std::endl;
+    for (auto& each : summary.get_features_overview())
+      ss << "  " << each.first << std::endl;
   }
   ss << "+++++" << std::endl;
   ss << "Total # of primitives: " << setw(8) << noprim << std::endl;
-  int bValid = 0;
-  for (auto& f : lsFeatures)
-    for (auto& p : f->get_primitives())
-      if (p->is_valid() == true)
-        bValid++;
+  int bValid = summary.number_primitives_valid();
   if (noprim  == 0)
     percentage = 0;
   else
@@ -852,17 +1035,13 @@ std::string print_summary_validation(std::vector<Feature*>& lsFeatures, IOErrors
     ss << std::fixed << setprecision(1) << " (" << 100 - percentage << "%)" << std::endl;
   ss << "  # invalid: " << setw(18) << (noprim - bValid);
   ss << std::fixed << setprecision(1) << " (" << percentage << "%)" << std::endl;
-  std::set<int> theprimitives;
-  for (auto& f : lsFeatures)
-    for (auto& p : f->get_primitives())
-      theprimitives.insert(p->get_type());
-  if (theprimitives.empty() == false)
+  if (summary.get_primitives_overview().empty() == false)
   {
     ss << "Types:" << std::endl;
-    for (auto& each : theprimitives)
+    for (auto& each : summary.get_primitives_overview())
     {
       ss << "  ";
-      switch(each)
+      switch(each.first)
       {
         case 0: ss << "Solid"             << std::endl; break;
         case 1: ss << "CompositeSolid"    << std::endl; break;
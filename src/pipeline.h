@@ -0,0 +1,176 @@
+/*
+  val3dity
+
+  Copyright (c) 2011-2024, 3D geoinformation research group, TU Delft
+
+  This file is part of val3dity.
+
+  val3dity is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  val3dity is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with val3dity.  If not, see <http://www.gnu.org/licenses/>.
+
+  For any information or further details about the use of val3dity, contact
+  Hugo Ledoux
+  <h.ledoux@tudelft.nl>
+  Faculty of Architecture & the Built Environment
+  Delft University of Technology
+  Julianalaan 134, Delft 2628BL, the Netherlands
+*/
+
+#ifndef VAL3DITY_PIPELINE_H
+#define VAL3DITY_PIPELINE_H
+
+#include <istream>
+#include <string>
+#include <deque>
+#include <map>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdint>
+
+
+namespace val3dity
+{
+
+//-- Processes the lines of a stream (eg a CityJSONSeq) with several threads:
+//--   - one thread reads the lines and puts them in a queue;
+//--   - 'jobs' threads take the lines from the queue and call 'work' on them;
+//--   - the calling thread gives the results to 'collect', in the order of the lines.
+//-- At most 'maxinflight' lines are read but not yet collected, to bound the memory.
+//-- 'work' can be called concurrently, 'collect' is called by one thread only.
+//-- If 'work' throws, the result of the line is built by 'failed' (with the exception),
+//-- the exception does not leave the thread. When 'collect' returns false no more
+//-- lines are read and scheduled, and the lines already read are dropped.
+template <typename T>
+void process_lines_in_parallel(std::istream& input,
+                               int jobs,
+                               std::size_t maxinflight,
+                               std::function<T(std::string&)> work,
+                               std::function<T(std::string&, const std::exception&)> failed,
+                               std::function<bool(T&)> collect)
+{
+  std::mutex                                      mtx;
+  std::condition_variable                         cv_read;
+  std::condition_variable                         cv_work;
+  std::condition_variable                         cv_collect;
+  std::deque<std::pair<std::size_t, std::string>> queue;    //-- lines read, waiting for a worker
+  std::map<std::size_t, T>                        done;     //-- reorder buffer
+  std::size_t                                     noread = 0;
+  std::size_t                                     nocollected = 0;
+  std::size_t                                     lastline = SIZE_MAX; //-- no line after it is processed
+  bool                                            eof = false;
+  if (jobs < 1)
+    jobs = 1;
+  if (maxinflight < std::size_t(jobs))
+    maxinflight = jobs;
+
+  std::thread reader([&]() {
+    std::string l;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv_read.wait(lock, [&] { return ((noread - nocollected) < maxinflight) || (noread > lastline); });
+        if (noread > lastline)
+          break;
+      }
+      if (!std::getline(input, l))
+        break;
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.emplace_back(noread, std::move(l));
+        noread++;
+      }
+      cv_work.notify_one();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      eof = true;
+    }
+    cv_work.notify_all();
+    cv_collect.notify_all();
+  });
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < jobs; i++)
+  {
+    workers.emplace_back([&]() {
+      while (true)
+      {
+        std::pair<std::size_t, std::string> item;
+        {
+          std::unique_lock<std::mutex> lock(mtx);
+          cv_work.wait(lock, [&] { return (queue.empty() == false) || (eof == true); });
+          if (queue.empty() == true)
+            break;
+          item = std::move(queue.front());
+          queue.pop_front();
+          if (item.first > lastline)
+            continue;
+        }
+        T r;
+        try
+        {
+          r = work(item.second);
+        }
+        catch (const std::exception& e)
+        {
+          r = failed(item.second, e);
+        }
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          done.emplace(item.first, std::move(r));
+        }
+        cv_collect.notify_one();
+      }
+    });
+  }
+
+  while (true)
+  {
+    T r;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv_collect.wait(lock, [&] {
+        return (done.count(nocollected) == 1) || (nocollected > lastline) || ( (eof == true) && (nocollected == noread) );
+      });
+      auto it = done.find(nocollected);
+      if ( (it == done.end()) || (nocollected > lastline) )
+        break;
+      r = std::move(it->second);
+      done.erase(it);
+      nocollected++;
+    }
+    cv_read.notify_one();
+    if (collect(r) == false)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        lastline = nocollected - 1;
+      }
+      cv_read.notify_all();
+      cv_work.notify_all();
+    }
+  }
+
+  reader.join();
+  for (auto& w : workers)
+    w.join();
+}
+
+} // namespace val3dity
+
+#endif
@@ -0,0 +1,224 @@
+/*
+  val3dity
+
+  Copyright (c) 2011-2024, 3D geoinformation research group, TU Delft
+
+  This file is part of val3dity.
+
+  val3dity is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  val3dity is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with val3dity.  If not, see <http://www.gnu.org/licenses/>.
+
+  For any information or further details about the use of val3dity, contact
+  Hugo Ledoux
+  <h.ledoux@tudelft.nl>
+  Faculty of Architecture & the Built Environment
+  Delft University of Technology
+  Julianalaan 134, Delft 2628BL, the Netherlands
+*/
+
+#ifndef VAL3DITY_TEXTINPUT_H
+#define VAL3DITY_TEXTINPUT_H
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+
+namespace val3dity
+{
+
+//-- A file mapped in memory (read-only), so that it can be parsed without
+//-- copying it. On Windows the file is simply read in a buffer.
+//-- With 'writable' the mapping is private (copy-on-write): the buffer can be
+//-- modified (eg by an in-place parser) and the file on disk is not changed.
+class MappedFile
+{
+public:
+  MappedFile() {}
+  ~MappedFile() { close(); }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(const std::string& path, bool writable = false)
+  {
+    close();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if ( (::fstat(fd, &st) != 0) || (S_ISREG(st.st_mode) == false) ) {
+      ::close(fd);
+      return false;
+    }
+    _size = std::size_t(st.st_size);
+    if (_size > 0) {
+      int prot = (writable == true) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+      void* p = ::mmap(nullptr, _size, prot, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        _size = 0;
+        return false;
+      }
+      ::madvise(p, _size, MADV_SEQUENTIAL);
+      _data = static_cast<char*>(p);
+      _mapped = true;
+    }
+    ::close(fd);
+    return true;
+#else
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+      return false;
+    std::ostringstream ss;
+    ss << input.rdbuf();
+    _buffer = ss.str();
+    _data = &_buffer[0];
+    _size = _buffer.size();
+    return true;
+#endif
+  }
+
+  void close()
+  {
+#ifndef _WIN32
+    if (_mapped == true)
+      ::munmap(_data, _size);
+#else
+    _buffer.clear();
+#endif
+    _data = nullptr;
+    _size = 0;
+    _mapped = false;
+  }
+
+  char*        data() const { return _data; }
+  std::size_t  size() const { return _size; }
+
+private:
+  char*        _data = nullptr;
+  std::size_t  _size = 0;
+  bool         _mapped = false;
+#ifdef _WIN32
+  std::string  _buffer;
+#endif
+};
+
+
+//-- Reads the numbers and words of a text buffer (OBJ, OFF, POLY, GML posList, etc.)
+//-- with std::from_chars: no stream, no locale, no copy of the tokens.
+class TextScanner
+{
+public:
+  TextScanner(const char* begin, const char* end) : _p(begin), _end(end) {}
+
+  bool eof() {
+    skip_whitespace();
+    return (_p == _end);
+  }
+  //-- true if there's nothing else on the current line
+  bool at_eol() {
+    skip_blanks();
+    return ( (_p == _end) || (*_p == '\n') );
+  }
+  void skip_line() {
+    while ( (_p != _end) && (*_p != '\n') )
+      _p++;
+    if (_p != _end)
+      _p++;
+  }
+  void skip_whitespace() {
+    while ( (_p != _end) && ( (*_p == ' ') || (*_p == '\t') || (*_p == '\r') || (*_p == '\n') ) )
+      _p++;
+  }
+  //-- next word (anything up to a whitespace), empty if none
+  std::string_view read_word() {
+    skip_whitespace();
+    const char* b = _p;
+    while ( (_p != _end) && (*_p != ' ') && (*_p != '\t') && (*_p != '\r') && (*_p != '\n') )
+      _p++;
+    return std::string_view(b, _p - b);
+  }
+  //-- next word, but not beyond the end of the current line
+  std::string_view read_word_on_line() {
+    if (at_eol() == true)
+      return std::string_view();
+    return read_word();
+  }
+  bool read_int(int& v) {
+    skip_whitespace();
+    if ( (_p != _end) && (*_p == '+') )
+      _p++;
+    auto r = std::from_chars(_p, _end, v);
+    if (r.ec != std::errc())
+      return false;
+    _p = r.ptr;
+    return true;
+  }
+  bool read_double(double& v) {
+    skip_whitespace();
+    return parse_double(_p, _end, v);
+  }
+
+  //-- parses a double at b and moves b after it
+  static bool parse_double(const char*& b, const char* end, double& v) {
+    if ( (b != end) && (*b == '+') )
+      b++;
+#if defined(__cpp_lib_to_chars)
+    auto r = std::from_chars(b, end, v);
+    if (r.ec != std::errc())
+      return false;
+    b = r.ptr;
+    return true;
+#else
+    //-- no std::from_chars for floating-point (older libstdc++/libc++): strtod on a copy
+    char tmp[64];
+    std::size_t n = 0;
+    while ( (b + n != end) && (n < 63) && (std::strchr(" \t\r\n", b[n]) == nullptr) ) {
+      tmp[n] = b[n];
+      n++;
+    }
+    tmp[n] = '\0';
+    char* e;
+    v = std::strtod(tmp, &e);
+    if (e == tmp)
+      return false;
+    b += (e - tmp);
+    return true;
+#endif
+  }
+
+private:
+  const char*  _p;
+  const char*  _end;
+
+  void skip_blanks() {
+    while ( (_p != _end) && ( (*_p == ' ') || (*_p == '\t') || (*_p == '\r') ) )
+      _p++;
+  }
+};
+
+} // namespace val3dity
+
+#endif
@@ -30,6 +30,7 @@
 #include "Feature.h"
 #include "CityObject.h"
 #include "GenericObject.h"
+#include "GeometryTemplate.h"
 #include "Solid.h"
 #include "MultiSurface.h"
 #include "CompositeSurface.h"
@@ -125,7 +126,8 @@ validate_cityjson(json& j,
   std::vector<Feature*> lsFeatures;
   //-- parse the cityjson object
   //-- compute (_minx, _miny)
-  compute_min_xy(j);
+  std::vector<double> vertices;
+  decode_json_vertices(j, vertices, true);
   //-- read and store the GeometryTemplates
   std::vector<GeometryTemplate*> lsGTs;
   if (j.count("geometry-templates") == 1)
@@ -139,13 +141,13 @@ validate_cityjson(json& j,
       if (it.value()["type"] == "BuildingPart")
           continue;
       CityObject* co = new CityObject(it.key(), it.value()["type"]);
-      process_json_geometries_of_co(it.value(), co, co->get_id(), lsGTs, j, params._tol_snap);
+      process_json_geometries_of_co(it.value(), co, co->get_id(), lsGTs, vertices, params._tol_snap);
       //-- if Building has Parts, put them here in _lsPrimitives
       if ( (it.value()["type"] == "Building") && (it.value().count("children") != 0) )
       {
           for (std::string bpid : it.value()["children"])
           {
-              process_json_geometries_of_co(j["CityObjects"][bpid], co, bpid, lsGTs, j, params._tol_snap);
+              process_json_geometries_of_co(j["CityObjects"][bpid], co, bpid, lsGTs, vertices, params._tol_snap);
           }
       }
       lsFeatures.push_back(co);
@@ -170,6 +172,10 @@ validate_cityjson(json& j,
                             params._planarity_d2p_tol,
                             params._planarity_n_tol,
                             ioerrs);
+  for (auto& f : lsFeatures)
+      delete f;
+  for (auto& gt : lsGTs)
+      delete gt;
   return jr;
 }
 
@@ -180,7 +186,8 @@ validate_cityjsonfeature(json& j,
   // j["transform"] = jtransform;
   std::vector<Feature*> lsFeatures;
   //-- compute (_minx, _miny)
-  compute_min_xy(j);
+  std::vector<double> vertices;
+  decode_json_vertices(j, vertices, true);
   //-- list empty GeometryTemplate TODO: populate this?
   std::vector<GeometryTemplate*> lsGTs;
   //-- process each CO
@@ -190,13 +197,13 @@ validate_cityjsonfeature(json& j,
       if (it.value()["type"] == "BuildingPart")
           continue;
       CityObject* co = new CityObject(it.key(), it.value()["type"]);
-      process_json_geometries_of_co(it.value(), co, co->get_id(), lsGTs, j, params._tol_snap);
+      process_json_geometries_of_co(it.value(), co, co->get_id(), lsGTs, vertices, params._tol_snap);
       //-- if Building has Parts, put them here in _lsPrimitives
       if ( (it.value()["type"] == "Building") && (it.value().count("children") != 0) )
       {
           for (std::string bpid : it.value()["children"])
           {
-              process_json_geometries_of_co(j["CityObjects"][bpid], co, bpid, lsGTs, j, params._tol_snap);
+              process_json_geometries_of_co(j["CityObjects"][bpid], co, bpid, lsGTs, vertices, params._tol_snap);
           }
       }
       lsFeatures.push_back(co);
@@ -221,17 +228,21 @@ validate_cityjsonfeature(json& j,
                             params._planarity_d2p_tol,
                             params._planarity_n_tol,
                             ioerrs);
+  for (auto& f : lsFeatures)
+      delete f;
+  for (auto& gt : lsGTs)
+      delete gt;
   return jr;
 }
 
+//-- doc is already loaded, from a copy of the input or in-place in the input
 json
-validate_indoorgml(std::string& input,
+validate_indoorgml(pugi::xml_document& doc,
+                   pugi::xml_parse_result& result,
                    Parameters params)
 {
   IOErrors ioerrs;
   ioerrs.set_input_file_type("IndoorGML");
-  pugi::xml_document doc;
-  pugi::xml_parse_result result = doc.load_string(input.c_str());
   if (!result) {
       ioerrs.add_error(901, "Input value not valid XML");
   }
@@ -241,13 +252,11 @@ validate_indoorgml(std::string& input,
       pugi::xml_node ncm = doc.first_child();
       std::map<std::string, std::string> thens = get_namespaces(ncm); //-- results in global variable NS in this unit
       if ( (thens.count("indoorgml") != 0) && (ncm.name() == (thens["indoorgml"] + "IndoorFeatures")) ) {
-          //-- find (_minx, _miny)
-          compute_min_xy(doc);
-          //-- build dico of xlinks for <gml:Polygon>
-          std::map<std::string, pugi::xpath_node> dallpoly;
-          build_dico_xlinks(doc, dallpoly, ioerrs);
+          //-- find (_minx, _miny), parse the coordinates and build dico of xlinks for <gml:Polygon>
+          GMLIndex gmlindex;
+          build_gml_index(doc, gmlindex, ioerrs);
           ioerrs.set_input_file_type("IndoorGML");
-          process_gml_file_indoorgml(doc, lsFeatures, dallpoly, ioerrs, params._tol_snap);
+          process_gml_file_indoorgml(doc, lsFeatures, gmlindex, ioerrs, params._tol_snap);
       }
       else
       {
@@ -273,14 +282,14 @@ validate_indoorgml(std::string& input,
 }
 
 json
-validate_obj(std::string& input,
+validate_obj(const char* buffer,
+             std::size_t size,
              Parameters params)
 {
   IOErrors ioerrs;
   ioerrs.set_input_file_type("OBJ");
   std::vector<Feature*> lsFeatures;
-  std::istringstream iss(input);
-  parse_obj(iss, lsFeatures, params._primitive, ioerrs, params._tol_snap);
+  parse_obj(buffer, size, lsFeatures, params._primitive, ioerrs, params._tol_snap);
   //-- start the validation
   if (ioerrs.has_errors() == false) {
       //-- validate
@@ -300,15 +309,15 @@ validate_obj(std::string& input,
 }
 
 json
-validate_off(std::string& input,
+validate_off(const char* buffer,
+             std::size_t size,
              Parameters params)
 {
   IOErrors ioerrs;
   ioerrs.set_input_file_type("OFF");
   std::vector<Feature*> lsFeatures;
   GenericObject* o = new GenericObject("none");
-  std::istringstream iss(input);
-  Surface* sh = parse_off(iss, 0, ioerrs, params._tol_snap);
+  Surface* sh = parse_off(buffer, size, 0, ioerrs, params._tol_snap);
   if (params._primitive == SOLID)
   {
     Solid* sol = new Solid("");
@@ -587,15 +596,58 @@ validate(std::string& input,
   spdlog::set_level(spdlog::level::off);
   json re;
   if (format == "IndoorGML") {
-    json j = validate_indoorgml(input, params);
+    //-- pugixml parses a copy, the input is not modified
+    pugi::xml_document doc;
+    pugi::xml_parse_result result = doc.load_buffer(input.data(), input.size());
+    json j = validate_indoorgml(doc, result, params);
+    re = j;
+  }
+  else if (format == "OBJ") {
+    json j = validate_obj(input.data(), input.size(), params);
+    re = j;
+  }
+  else if (format == "OFF") {
+    json j = validate_off(input.data(), input.size(), params);
+    re = j;
+  }
+  else { 
+    throw verror("File type not supported");
+  }
+  return re;
+}
+
+//-- for ASCII + XML formats, the buffer is owned by the caller and is not copied
+bool 
+is_valid(char* buffer,
+         std::size_t size,
+         std::string format,
+         Parameters params)
+{
+  json re = validate(buffer, size, format, params);
+  return re["validity"];
+}
+
+json
+validate(char* buffer,
+         std::size_t size,
+         std::string format,
+         Parameters params)
+{
+  spdlog::set_level(spdlog::level::off);
+  json re;
+  if (format == "IndoorGML") {
+    //-- parsed in-place: the buffer is modified and must outlive the validation
+    pugi::xml_document doc;
+    pugi::xml_parse_result result = doc.load_buffer_inplace(buffer, size);
+    json j = validate_indoorgml(doc, result, params);
     re = j;
   }
   else if (format == "OBJ") {
-    json j = validate_obj(input, params);
+    json j = validate_obj(buffer, size, params);
     re = j;
   }
   else if (format == "OFF") {
-    json j = validate_off(input, params);
+    json j = validate_off(buffer, size, params);
     re = j;
   }
   else { 
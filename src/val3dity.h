@@ -87,6 +87,20 @@ validate(std::string& input,
          std::string format,
          Parameters params = Parameters());
 
+//-- same as above, but the input is a buffer owned by the caller, which is 
+//-- not copied; for IndoorGML it is parsed in-place (so it is modified)
+bool
+is_valid(char* buffer,
+         std::size_t size,
+         std::string format,
+         Parameters params = Parameters());
+
+json
+validate(char* buffer,
+         std::size_t size,
+         std::string format,
+         Parameters params = Parameters());
+
 
 json
 validate(const std::vector<std::array<double, 3>>& vertices,
@@ -0,0 +1,351 @@
+/*
+  val3dity 
+
+  Copyright (c) 2011-2024, 3D geoinformation research group, TU Delft  
+
+  This file is part of val3dity.
+
+  val3dity is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  val3dity is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with val3dity.  If not, see <http://www.gnu.org/licenses/>.
+
+  For any information or further details about the use of val3dity, contact
+  Hugo Ledoux
+  <h.ledoux@tudelft.nl>
+  Faculty of Architecture & the Built Environment
+  Delft University of Technology
+  Julianalaan 134, Delft 2628BL, the Netherlands
+*/
+
+#include "validate_polygon2d.h"
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+namespace val3dity
+{
+
+typedef K::Segment_2  Segment2;
+
+//-- an edge of a ring, from vertex i to vertex i+1, with its bbox for the sweep
+struct Edge2
+{
+  int     ring;
+  int     i;
+  double  xmin, xmax, ymin, ymax;
+};
+
+//-- 2 different rings intersecting at one point p (a vertex and/or inside an edge)
+struct RingsContact
+{
+  int     ring1, edge1;
+  int     ring2, edge2;
+  Point2  p;
+};
+
+
+static std::string reason_at(const std::string& reason, const Point2& p)
+{
+  std::stringstream ss;
+  ss << setprecision(15) << reason << "[" << p.x() << " " << p.y() << "]";
+  return ss.str();
+}
+
+
+//-- the 2 neighbours of p along the ring, p being on the edge e of the ring
+static void get_neighbours(const Polygon& ring, int e, const Point2& p, Point2& n0, Point2& n1)
+{
+  int n = static_cast<int>(ring.size());
+  const Point2& a = ring[e];
+  const Point2& b = ring[(e + 1) % n];
+  if (p == a) {
+    n0 = ring[(e + n - 1) % n];
+    n1 = b;
+  }
+  else if (p == b) {
+    n0 = a;
+    n1 = ring[(e + 2) % n];
+  }
+  else {
+    n0 = a;
+    n1 = b;
+  }
+}
+
+
+//-- is x strictly inside the wedge at p going CCW from the ray p->a0 to the ray p->a1?
+static bool is_in_wedge(const Point2& a0, const Point2& p, const Point2& a1, const Point2& x)
+{
+  CGAL::Orientation o = CGAL::orientation(p, a0, a1);
+  if (o == CGAL::LEFT_TURN)
+    return ( (CGAL::orientation(p, a0, x) == CGAL::LEFT_TURN) && (CGAL::orientation(p, a1, x) == CGAL::RIGHT_TURN) );
+  else if (o == CGAL::RIGHT_TURN)
+    return ( (CGAL::orientation(p, a0, x) == CGAL::LEFT_TURN) || (CGAL::orientation(p, a1, x) == CGAL::RIGHT_TURN) );
+  else 
+    return (CGAL::orientation(p, a0, x) == CGAL::LEFT_TURN);
+}
+
+
+//-- a vertex of ring r1 that is not one of the contact points with ring r2
+static bool get_free_vertex(const Polygon& ring, const std::set<std::pair<double,double>>& contacts, Point2& v)
+{
+  for (auto it = ring.vertices_begin(); it != ring.vertices_end(); it++)
+  {
+    if (contacts.count(std::make_pair(it->x(), it->y())) == 0) {
+      v = *it;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+static int find_root(std::vector<int>& parent, int i)
+{
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+
+bool validate_polygon_2d(const std::vector<Polygon>& lsRings, std::vector<Polygon2DError>& errors)
+{
+  int nrings = static_cast<int>(lsRings.size());
+  std::vector<bool> ringok(nrings, true);
+  //-- 1. the edges of all the rings, sorted by xmin
+  std::vector<Edge2> edges;
+  for (int r = 0; r < nrings; r++)
+  {
+    int n = static_cast<int>(lsRings[r].size());
+    if (n < 3)
+      ringok[r] = false;
+    for (int i = 0; i < n; i++)
+    {
+      const Point2& a = lsRings[r][i];
+      const Point2& b = lsRings[r][(i + 1) % n];
+      edges.push_back({r, i, std::min(a.x(), b.x()), std::max(a.x(), b.x()), 
+                             std::min(a.y(), b.y()), std::max(a.y(), b.y())});
+    }
+  }
+  std::sort(edges.begin(), edges.end(), [](const Edge2& e1, const Edge2& e2) { return e1.xmin < e2.xmin; });
+  //-- 2. sweep: each edge is tested against the following edges whose x-interval overlaps.
+  //--    Intersections within a ring invalidate it (104), those between 2 rings are kept.
+  std::vector<RingsContact> contacts;
+  std::vector<RingsContact> crossings;  //-- proper crossings and overlaps
+  for (std::size_t s = 0; s < edges.size(); s++)
+  {
+    const Edge2& e1 = edges[s];
+    for (std::size_t t = s + 1; (t < edges.size()) && (edges[t].xmin <= e1.xmax); t++)
+    {
+      const Edge2& e2 = edges[t];
+      if ( (e2.ymin > e1.ymax) || (e2.ymax < e1.ymin) )
+        continue;
+      const Polygon& ring1 = lsRings[e1.ring];
+      const Polygon& ring2 = lsRings[e2.ring];
+      int n1 = static_cast<int>(ring1.size());
+      int n2 = static_cast<int>(ring2.size());
+      const Point2& a = ring1[e1.i];
+      const Point2& b = ring1[(e1.i + 1) % n1];
+      const Point2& c = ring2[e2.i];
+      const Point2& d = ring2[(e2.i + 1) % n2];
+      if (e1.ring == e2.ring) 
+      {
+        if (ringok[e1.ring] == false)
+          continue;
+        if ( (e2.i == (e1.i + 1) % n1) || (e1.i == (e2.i + 1) % n1) )
+        {
+          //-- adjacent edges: only their common vertex, unless the ring folds back on itself
+          const Point2& v = (e2.i == (e1.i + 1) % n1) ? b : a;
+          const Point2& u = (e2.i == (e1.i + 1) % n1) ? a : b;
+          const Point2& w = (e2.i == (e1.i + 1) % n1) ? d : c;
+          if ( (CGAL::orientation(u, v, w) == CGAL::COLLINEAR) && 
+               (CGAL::collinear_are_strictly_ordered_along_line(u, v, w) == false) )
+            ringok[e1.ring] = false;
+        }
+        else if (CGAL::do_intersect(Segment2(a, b), Segment2(c, d)) == true)
+          ringok[e1.ring] = false;
+        continue;
+      }
+      if (CGAL::do_intersect(Segment2(a, b), Segment2(c, d)) == false)
+        continue;
+      CGAL::Orientation o1 = CGAL::orientation(a, b, c);
+      CGAL::Orientation o2 = CGAL::orientation(a, b, d);
+      CGAL::Orientation o3 = CGAL::orientation(c, d, a);
+      CGAL::Orientation o4 = CGAL::orientation(c, d, b);
+      RingsContact rc = {e1.ring, e1.i, e2.ring, e2.i, a};
+      if ( (o1 == CGAL::COLLINEAR) && (o2 == CGAL::COLLINEAR) )
+      {
+        //-- collinear: they overlap, or they touch at one endpoint
+        std::vector<Point2> ps;
+        for (const Point2* p : {&c, &d})
+          if (CGAL::collinear_are_ordered_along_line(a, *p, b) == true)
+            ps.push_back(*p);
+        for (const Point2* p : {&a, &b})
+          if (CGAL::collinear_are_ordered_along_line(c, *p, d) == true)
+            ps.push_back(*p);
+        rc.p = ps[0];
+        bool overlap = false;
+        for (auto& p : ps)
+          if (p != ps[0])
+            overlap = true;
+        if (overlap == true)
+          crossings.push_back(rc);
+        else
+          contacts.push_back(rc);
+      }
+      else if ( (int(o1) * int(o2) < 0) && (int(o3) * int(o4) < 0) )
+      {
+        //-- proper crossing, the location is only for the report
+        double den = (b.x() - a.x()) * (d.y() - c.y()) - (b.y() - a.y()) * (d.x() - c.x());
+        double u = ((c.x() - a.x()) * (d.y() - c.y()) - (c.y() - a.y()) * (d.x() - c.x())) / den;
+        rc.p = Point2(a.x() + u * (b.x() - a.x()), a.y() + u * (b.y() - a.y()));
+        crossings.push_back(rc);
+      }
+      else
+      {
+        //-- they touch at one point, which is an endpoint of one of the 2 edges
+        if ( (o1 == CGAL::COLLINEAR) && (CGAL::collinear_are_ordered_along_line(a, c, b) == true) )
+          rc.p = c;
+        else if ( (o2 == CGAL::COLLINEAR) && (CGAL::collinear_are_ordered_along_line(a, d, b) == true) )
+          rc.p = d;
+        else if ( (o3 == CGAL::COLLINEAR) && (CGAL::collinear_are_ordered_along_line(c, a, d) == true) )
+          rc.p = a;
+        else
+          rc.p = b;
+        contacts.push_back(rc);
+      }
+    }
+  }
+  //-- 3. 104: not simple or collapsed to a line. 
+  //--    If the oring is invalid the irings are not looked at.
+  std::vector<CGAL::Orientation> orientations(nrings, CGAL::COLLINEAR);
+  for (int r = 0; r < nrings; r++)
+  {
+    if (ringok[r] == true) {
+      orientations[r] = lsRings[r].orientation();
+      if (orientations[r] == CGAL::COLLINEAR)
+        ringok[r] = false;
+    }
+    if (ringok[r] == false) {
+      errors.push_back({104, r, "ring self-intersects or is collapsed to a line"});
+      if (r == 0)
+        return false;
+    }
+  }
+  //-- 4. 208: we don't care about CCW or CW, just opposite is important
+  for (int r = 1; r < nrings; r++)
+  {
+    if ( (ringok[r] == true) && (orientations[r] == orientations[0]) ) {
+      errors.push_back({208, r, "same orientation for outer and inner rings"});
+      return false;
+    }
+  }
+  //-- 5. 202: 2 rings with the same vertices
+  for (int r1 = 0; r1 < nrings; r1++)
+  {
+    for (int r2 = r1 + 1; r2 < nrings; r2++)
+    {
+      if ( (ringok[r1] == false) || (ringok[r2] == false) || 
+           (lsRings[r1].size() != lsRings[r2].size()) || (lsRings[r1].bbox() != lsRings[r2].bbox()) )
+        continue;
+      std::vector<Point2> v1(lsRings[r1].vertices_begin(), lsRings[r1].vertices_end());
+      std::vector<Point2> v2(lsRings[r2].vertices_begin(), lsRings[r2].vertices_end());
+      std::sort(v1.begin(), v1.end());
+      std::sort(v2.begin(), v2.end());
+      if (v1 == v2) {
+        errors.push_back({202, r2, reason_at("Duplicate Rings", v1[0])});
+        return false;
+      }
+    }
+  }
+  //-- 6. 201: 2 rings crossing or overlapping, or crossing at a contact point
+  for (auto& rc : crossings)
+  {
+    if ( (ringok[rc.ring1] == true) && (ringok[rc.ring2] == true) ) {
+      errors.push_back({201, rc.ring2, reason_at("Self-intersection", rc.p)});
+      return false;
+    }
+  }
+  std::map<std::pair<int,int>, std::set<std::pair<double,double>>> dcontacts;
+  for (auto& rc : contacts)
+  {
+    if ( (ringok[rc.ring1] == false) || (ringok[rc.ring2] == false) )
+      continue;
+    Point2 n0, n1, m0, m1;
+    get_neighbours(lsRings[rc.ring1], rc.edge1, rc.p, n0, n1);
+    get_neighbours(lsRings[rc.ring2], rc.edge2, rc.p, m0, m1);
+    if (is_in_wedge(n0, rc.p, n1, m0) != is_in_wedge(n0, rc.p, n1, m1)) {
+      errors.push_back({201, rc.ring2, reason_at("Self-intersection", rc.p)});
+      return false;
+    }
+    std::pair<int,int> k = std::make_pair(std::min(rc.ring1, rc.ring2), std::max(rc.ring1, rc.ring2));
+    dcontacts[k].insert(std::make_pair(rc.p.x(), rc.p.y()));
+  }
+  //-- 7. 206: a vertex of each iring (not on the oring) must be inside the oring
+  std::set<std::pair<double,double>> empty;
+  for (int r = 1; r < nrings; r++)
+  {
+    if (ringok[r] == false)
+      continue;
+    auto it = dcontacts.find(std::make_pair(0, r));
+    Point2 v;
+    if (get_free_vertex(lsRings[r], (it == dcontacts.end()) ? empty : it->second, v) == false)
+      continue;
+    if (lsRings[0].bounded_side(v) == CGAL::ON_UNBOUNDED_SIDE) {
+      errors.push_back({206, r, reason_at("Hole lies outside shell", v)});
+      return false;
+    }
+  }
+  //-- 8. 207: a vertex of an iring (not on the other) inside another iring
+  for (int r1 = 1; r1 < nrings; r1++)
+  {
+    for (int r2 = 1; r2 < nrings; r2++)
+    {
+      if ( (r1 == r2) || (ringok[r1] == false) || (ringok[r2] == false) || 
+           (CGAL::do_overlap(lsRings[r1].bbox(), lsRings[r2].bbox()) == false) )
+        continue;
+      auto it = dcontacts.find(std::make_pair(std::min(r1, r2), std::max(r1, r2)));
+      Point2 v;
+      if (get_free_vertex(lsRings[r1], (it == dcontacts.end()) ? empty : it->second, v) == false)
+        continue;
+      if (lsRings[r2].bounded_side(v) == CGAL::ON_BOUNDED_SIDE) {
+        errors.push_back({207, r1, reason_at("Holes are nested", v)});
+        return false;
+      }
+    }
+  }
+  //-- 9. 205: the interior is disconnected if 2 rings touch more than once, 
+  //--    or if the rings touching each other form a cycle
+  std::vector<int> parent(nrings);
+  for (int r = 0; r < nrings; r++)
+    parent[r] = r;
+  for (auto& each : dcontacts)
+  {
+    const std::pair<double,double>& p = *(each.second.begin());
+    int r1 = find_root(parent, each.first.first);
+    int r2 = find_root(parent, each.first.second);
+    if ( (each.second.size() > 1) || (r1 == r2) ) {
+      errors.push_back({205, each.first.second, reason_at("Interior is disconnected", Point2(p.first, p.second))});
+      return false;
+    }
+    parent[r1] = r2;
+  }
+  return errors.empty();
+}
+
+} // namespace val3dity
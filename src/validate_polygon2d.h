@@ -0,0 +1,55 @@
+/*
+  val3dity 
+
+  Copyright (c) 2011-2024, 3D geoinformation research group, TU Delft  
+
+  This file is part of val3dity.
+
+  val3dity is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  val3dity is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with val3dity.  If not, see <http://www.gnu.org/licenses/>.
+
+  For any information or further details about the use of val3dity, contact
+  Hugo Ledoux
+  <h.ledoux@tudelft.nl>
+  Faculty of Architecture & the Built Environment
+  Delft University of Technology
+  Julianalaan 134, Delft 2628BL, the Netherlands
+*/
+
+#ifndef Validate_polygon2d_h
+#define Validate_polygon2d_h
+
+#include "definitions.h"
+#include <string>
+#include <vector>
+
+namespace val3dity
+{
+
+//-- one error found in a (projected) polygon, 'ring' is only meaningful for 104
+struct Polygon2DError
+{
+  int         code;
+  int         ring;
+  std::string info;
+};
+
+//-- validates a polygon projected to 2D (oring first, then the irings) without 
+//-- GEOS: the edges of all the rings are intersected in one sweep and the
+//-- errors 104, 201, 202, 205, 206, 207 and 208 are derived from the result.
+//-- Like with GEOS, only the first error of 201-208 is reported. Returns true if valid.
+bool validate_polygon_2d(const std::vector<Polygon>& lsRings, std::vector<Polygon2DError>& errors);
+
+} // namespace val3dity
+
+#endif /* Validate_polygon2d_h */
@@ -34,15 +34,303 @@
 #include "CompositeSolid.h"
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <queue>
+#include <limits>
+#include <set>
+#include <map>
 
 #include <CGAL/box_intersection_d.h>
+#include <CGAL/version.h>
+#include <CGAL/Surface_mesh.h>
+#include <CGAL/boost/graph/copy_face_graph.h>
+#include <CGAL/Polygon_mesh_processing/corefinement.h>
+#include <CGAL/Polygon_mesh_processing/intersection.h>
+#include <CGAL/Polygon_mesh_processing/measure.h>
+#include <CGAL/Polygon_mesh_processing/compute_normal.h>
+#include <CGAL/Polygon_mesh_processing/connected_components.h>
+#include <CGAL/AABB_tree.h>
+#include <CGAL/AABB_traits.h>
+#include <CGAL/AABB_face_graph_triangle_primitive.h>
+#include <CGAL/Side_of_triangle_mesh.h>
 
 namespace val3dity
 {
 
-typedef std::vector<Nef_polyhedron*>                                    Nefs;
+typedef std::vector<Nef_polyhedron>                                     Nefs;
 typedef Nefs::iterator                                                  Iterator;
 typedef CGAL::Box_intersection_d::Box_with_handle_d<double,3,Iterator>  AABB;
+typedef CGAL::Surface_mesh<Point3>                                      SurfaceMesh;
+typedef CGAL::Surface_mesh<Point3E>                                     SurfaceMeshE;
+typedef CGAL::Box_intersection_d::Box_with_info_d<double,3,int>         AABBid;
+typedef CGAL::AABB_face_graph_triangle_primitive<SurfaceMesh>           MeshPrimitive;
+typedef CGAL::AABB_traits<K, MeshPrimitive>                             MeshTraits;
+typedef CGAL::AABB_tree<MeshTraits>                                     MeshTree;
+
+namespace PMP = CGAL::Polygon_mesh_processing;
+
+//-- number of threads to test the overlaps of the primitives of a Feature (0: all cores).
+//-- 1 by default: the threads share the Nefs, which is safe only if CGAL itself is
+static int _overlap_threads = 1;
+
+void set_overlap_threads(int threads)
+{
+  _overlap_threads = threads;
+}
+
+//-- the tolerance (overlap_tol) is applied with distances between triangle meshes 
+//-- instead of the Minkowski sums of the Nefs with a cube
+static bool _overlap_distances = false;
+
+void set_overlap_tol_with_distances(bool distances)
+{
+  _overlap_distances = distances;
+}
+
+bool get_overlap_tol_with_distances()
+{
+  return _overlap_distances;
+}
+
+
+//-- the pairs (i < j, sorted) of the bboxes that intersect
+static std::vector<std::pair<int, int>> get_intersecting_bboxes(const std::vector<CGAL::Bbox_3>& bboxes)
+{
+  std::vector<AABBid> aabbs;
+  for (int i = 0; i < bboxes.size(); i++)
+    aabbs.push_back(AABBid(bboxes[i], i));
+  std::vector<std::pair<int, int>> pairs;
+  CGAL::box_self_intersection_d(aabbs.begin(), aabbs.end(), [&](const AABBid& a, const AABBid& b) {
+    pairs.push_back(std::make_pair(std::min(a.info(), b.info()), std::max(a.info(), b.info())));
+  });
+  std::sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+
+
+//-- all the shells of a (valid) Solid in one triangle mesh, the inner shells are 
+//-- oriented inwards so the volume of the mesh is that of the Solid
+static SurfaceMesh get_solid_mesh(Solid* s)
+{
+  SurfaceMesh m;
+  for (auto& sh : s->get_shells())
+    CGAL::copy_face_graph(*(sh->get_cgal_polyhedron()), m);
+  return m;
+}
+
+
+//-- signed distance from a point to the boundary of a Solid (positive inside)
+class SolidDistance
+{
+public:
+  SolidDistance(Solid* s)
+    : _mesh(get_solid_mesh(s)),
+      _tree(faces(_mesh).first, faces(_mesh).second, _mesh),
+      _side(_mesh),
+      _bbox(s->get_bbox())
+  {
+    _tree.accelerate_distance_queries();
+    for (auto v : vertices(_mesh))
+      _pts.push_back(_mesh.point(v));
+    //-- the triangles of a face, and the faces parallel to it, give one direction (the
+    //-- normal or its opposite), kept once with the extent of the solid along it
+    std::set<std::array<long long, 3>> seen;
+    for (auto f : faces(_mesh))
+    {
+      Vector n = PMP::compute_face_normal(f, _mesh);
+      std::array<long long, 3> key = {std::llround(n.x() * 1e6), std::llround(n.y() * 1e6), std::llround(n.z() * 1e6)};
+      if (key < std::array<long long, 3>{-key[0], -key[1], -key[2]})
+      {
+        n = -n;
+        key = {-key[0], -key[1], -key[2]};
+      }
+      if (seen.insert(key).second == true)
+      {
+        Direction d;
+        d.n = n;
+        extent(n, d.min, d.max);
+        _directions.push_back(d);
+      }
+    }
+  }
+  double operator()(const Point3& p) const
+  {
+    double d = std::sqrt(CGAL::to_double(_tree.squared_distance(p)));
+    return (_side(p) == CGAL::ON_BOUNDED_SIDE) ? d : -d;
+  }
+  const CGAL::Bbox_3& bbox() const { return _bbox; }
+  struct Direction {
+    Vector n;
+    double min;
+    double max;
+  };
+  const std::vector<Direction>& directions() const { return _directions; }
+  //-- extent of the solid along a direction
+  void extent(const Vector& n, double& min, double& max) const
+  {
+    min = std::numeric_limits<double>::max();
+    max = -std::numeric_limits<double>::max();
+    for (auto& p : _pts)
+    {
+      double t = n * (p - CGAL::ORIGIN);
+      min = std::min(min, t);
+      max = std::max(max, t);
+    }
+  }
+
+private:
+  SurfaceMesh                                 _mesh;
+  MeshTree                                    _tree;
+  CGAL::Side_of_triangle_mesh<SurfaceMesh, K> _side;
+  CGAL::Bbox_3                                _bbox;
+  std::vector<Point3>                         _pts;
+  std::vector<Direction>                      _directions;
+};
+
+
+//-- is there a point where the signed distances to both solids are larger than 
+//-- 'depth'? With depth = tol the solids eroded by tol overlap, with depth = -tol the 
+//-- solids dilated by tol overlap (the tolerance is a ball and not a cube). 
+//-- The minimum of the 2 distances is 1-Lipschitz: in a box with centre c and 
+//-- half-diagonal h it is at most f(c) + h, those boxes that cannot exceed 'depth' are 
+//-- pruned and the others are subdivided (the most promising first).
+//-- Such a point is in both bboxes shrunk (or grown) by 'depth', and more generally
+//-- in the slab between the projections of the solids on the normal of any of their 
+//-- faces: if one slab is thinner than 2 * 'depth' there is none. The extent of each 
+//-- solid along its own normals is cached, only the other one is projected.
+//-------------
+// -1: cannot be decided (too many boxes, 'depth' is almost reached)
+//  0: no
+//  1: yes
+static int is_depth_exceeded(const SolidDistance& a, const SolidDistance& b, double depth)
+{
+  struct Box {
+    double lo[3];
+    double hi[3];
+    double bound;
+  };
+  Box root;
+  for (int i = 0; i < 3; i++)
+  {
+    root.lo[i] = std::max(a.bbox().min(i), b.bbox().min(i)) + depth;
+    root.hi[i] = std::min(a.bbox().max(i), b.bbox().max(i)) - depth;
+    if (root.lo[i] > root.hi[i])
+      return 0;
+  }
+  for (auto* s : {&a, &b})
+  {
+    const SolidDistance* o = (s == &a) ? &b : &a;
+    for (auto& d : s->directions())
+    {
+      double omin, omax;
+      o->extent(d.n, omin, omax);
+      if ( ((d.max - omin) <= (2 * depth)) || ((omax - d.min) <= (2 * depth)) )
+        return 0;
+    }
+  }
+  int noevaluated = 0;
+  //-- true if 'depth' is exceeded at the centre of the box
+  auto evaluate = [&](Box& box) {
+    noevaluated++;
+    Point3 c((box.lo[0] + box.hi[0]) / 2, (box.lo[1] + box.hi[1]) / 2, (box.lo[2] + box.hi[2]) / 2);
+    double f = std::min(a(c), b(c));
+    if (f > depth)
+      return true;
+    double h = 0.0;
+    for (int i = 0; i < 3; i++)
+      h += (box.hi[i] - box.lo[i]) * (box.hi[i] - box.lo[i]);
+    box.bound = f + (std::sqrt(h) / 2);
+    return false;
+  };
+  auto cmp = [](const Box& x, const Box& y) { return x.bound < y.bound; };
+  std::priority_queue<Box, std::vector<Box>, decltype(cmp)> boxes(cmp);
+  if (evaluate(root) == true)
+    return 1;
+  if (root.bound > depth)
+    boxes.push(root);
+  while (boxes.empty() == false)
+  {
+    if (noevaluated > 200000)
+      return -1;
+    Box box = boxes.top();
+    boxes.pop();
+    //-- only the axes longer than half the longest are split
+    double longest = 0.0;
+    for (int i = 0; i < 3; i++)
+      longest = std::max(longest, box.hi[i] - box.lo[i]);
+    std::vector<int> axes;
+    for (int i = 0; i < 3; i++)
+    {
+      if ((box.hi[i] - box.lo[i]) >= (longest / 2))
+        axes.push_back(i);
+    }
+    for (int k = 0; k < (1 << axes.size()); k++)
+    {
+      Box child = box;
+      for (int j = 0; j < axes.size(); j++)
+      {
+        double mid = (box.lo[axes[j]] + box.hi[axes[j]]) / 2;
+        if ((k & (1 << j)) != 0)
+          child.lo[axes[j]] = mid;
+        else
+          child.hi[axes[j]] = mid;
+      }
+      if (evaluate(child) == true)
+        return 1;
+      if (child.bound > depth)
+        boxes.push(child);
+    }
+  }
+  return 0;
+}
+
+
+//-- the SolidDistance of each solid in a list is built once, when first needed
+class SolidDistances
+{
+public:
+  SolidDistances(std::size_t n) : _lsDistances(n) {}
+  const SolidDistance& get(int i, Solid* s)
+  {
+    if (_lsDistances[i] == nullptr)
+      _lsDistances[i].reset(new SolidDistance(s));
+    return *(_lsDistances[i]);
+  }
+
+private:
+  std::vector<std::unique_ptr<SolidDistance>> _lsDistances;
+};
+
+
+//-- the Nef of a Solid or a CompositeSolid eroded (or dilated) by a cube
+static Nef_polyhedron get_eroded_nef(Primitive* p, double tol_overlap)
+{
+  if (p->get_type() == SOLID)
+    return dynamic_cast<Solid*>(p)->get_eroded_nef_polyhedron(tol_overlap);
+  return erode_nef_polyhedron(*(dynamic_cast<CompositeSolid*>(p)->get_nef_polyhedron()), tol_overlap);
+}
+
+static Nef_polyhedron get_dilated_nef(Primitive* p, double tol_overlap)
+{
+  if (p->get_type() == SOLID)
+    return dynamic_cast<Solid*>(p)->get_dilated_nef_polyhedron(tol_overlap);
+  return dilate_nef_polyhedron(*(dynamic_cast<CompositeSolid*>(p)->get_nef_polyhedron()), tol_overlap);
+}
+
+
+//-- the reference: do the interiors of 2 primitives overlap once eroded (or dilated) 
+//-- by tol_overlap? With the Nefs and a cube
+static bool do_primitives_interior_overlap_nef(Primitive* p1, Primitive* p2, double tol_overlap, bool dilate)
+{
+  Nef_polyhedron a = (dilate == true) ? get_dilated_nef(p1, tol_overlap) : get_eroded_nef(p1, tol_overlap);
+  Nef_polyhedron b = (dilate == true) ? get_dilated_nef(p2, tol_overlap) : get_eroded_nef(p2, tol_overlap);
+  return ((a.interior() * b.interior()).is_empty() == false);
+}
 
 
 struct Report_intersections {
@@ -75,10 +363,10 @@ struct Report_intersections {
     // }
     //-- we check here if the 2 (usually eroded) Nefs are intersecting, 
     //-- if yes then an error is added to the list lsErrors
-    Nef_polyhedron* n1 = nefs->at(id1);
-    Nef_polyhedron* n2 = nefs->at(id2);
+    const Nef_polyhedron& n1 = nefs->at(id1);
+    const Nef_polyhedron& n2 = nefs->at(id2);
     Nef_polyhedron emptynef(Nef_polyhedron::EMPTY);
-    if (n1->interior() * n2->interior() != emptynef)
+    if (n1.interior() * n2.interior() != emptynef)
     {
       Error e;
       std::stringstream msg;
@@ -98,8 +386,34 @@ bool are_cells_interior_disconnected_with_aabb(std::vector<std::tuple<std::strin
                                                std::vector<Error>& lsErrors, 
                                                double tol_overlap)
 {
+  //-- with distances the cells are not eroded
+  if ( (tol_overlap > 0.0) && (_overlap_distances == true) )
+  {
+    std::vector<Solid*>      lsSolids;
+    std::vector<std::string> lsCellIDs;
+    for (auto& c : lsCells)
+    {
+      if (std::get<1>(c)->is_valid() != 1)
+        continue;
+      lsSolids.push_back(std::get<1>(c));
+      lsCellIDs.push_back(std::get<0>(c));
+    }
+    std::vector<std::pair<int, int>> overlaps;
+    find_solids_interior_overlap_distances(lsSolids, overlaps, tol_overlap);
+    for (auto& pr : overlaps)
+    {
+      Error e;
+      std::stringstream msg;
+      msg << lsCellIDs[pr.first] << "&&" << lsCellIDs[pr.second];
+      e.errorcode = errorcode_to_assign;
+      e.info1 = msg.str();
+      e.info2 = "";
+      lsErrors.push_back(e);
+    }
+    return overlaps.empty();
+  }
   // std::clog << "--- Constructing Nef Polyhedra ---" << std::endl;
-  std::vector<Nef_polyhedron*>                lsNefs;
+  Nefs                                        lsNefs;
   std::vector<std::tuple<std::string,Solid*>> subsetCells;
   for (auto& c : lsCells)
   {
@@ -107,14 +421,10 @@ bool are_cells_interior_disconnected_with_aabb(std::vector<std::tuple<std::strin
     // TODO: only valid Solids are processed: what's the best way here?
     if (ts->is_valid() != 1)
       continue;
-    Nef_polyhedron* tmpnef = ts->get_nef_polyhedron();
     if (tol_overlap > 0)
-    {
-      lsNefs.push_back(erode_nef_polyhedron(tmpnef, tol_overlap));
-      // delete tmpnef;
-    }
+      lsNefs.push_back(ts->get_eroded_nef_polyhedron(tol_overlap));
     else
-      lsNefs.push_back(tmpnef);
+      lsNefs.push_back(*(ts->get_nef_polyhedron()));
     subsetCells.push_back(c);
   }
   // std::clog << "--- Constructing AABB tree ---" << std::endl;
@@ -150,54 +460,587 @@ bool do_primitives_interior_overlap(std::vector<Primitive*>& lsPrimitives,
                                     double tol_overlap)
 {
   bool isValid = true;
-  //-- 1. create Nef for all primitives and erode if necessary
-  std::vector<Nef_polyhedron*> lsNefs;
+  //-- 1. the primitives that are tested (Solids and CompositeSolids)
+  std::vector<Primitive*>      lsPrims;
+  std::vector<CGAL::Bbox_3>    lsBboxes;
   for (auto& p : lsPrimitives)
   {
-    Nef_polyhedron* tmpnef;
-    if (p->get_type() == SOLID)
-      tmpnef = dynamic_cast<Solid*>(p)->get_nef_polyhedron();
-    else if (p->get_type() == COMPOSITESOLID)
-      tmpnef = dynamic_cast<CompositeSolid*>(p)->get_nef_polyhedron();
+    if (p->get_type() == SOLID) 
+      lsBboxes.push_back(dynamic_cast<Solid*>(p)->get_bbox());
+    else if (p->get_type() == COMPOSITESOLID) 
+      lsBboxes.push_back(dynamic_cast<CompositeSolid*>(p)->get_bbox());
     else
       continue;
-    if (tol_overlap > 0)
+    lsPrims.push_back(p);
+  }
+  //-- 2. only the pairs whose bboxes intersect are tested (an eroded Nef is inside
+  //-- the bbox of its primitive)
+  std::vector<std::pair<int, int>> pairs = get_intersecting_bboxes(lsBboxes);
+  //-- 3. with distances, the pairs of 2 Solids are decided without eroding their Nefs
+  std::vector<char> overlapping(pairs.size(), 0);
+  std::vector<char> decided(pairs.size(), 0);
+  if ( (tol_overlap > 0.0) && (_overlap_distances == true) )
+  {
+    SolidDistances distances(lsPrims.size());
+    for (std::size_t k = 0; k < pairs.size(); k++)
     {
-      lsNefs.push_back(erode_nef_polyhedron(tmpnef, tol_overlap));
-      // delete tmpnef;
+      Primitive* p1 = lsPrims[pairs[k].first];
+      Primitive* p2 = lsPrims[pairs[k].second];
+      if ( (p1->get_type() != SOLID) || (p2->get_type() != SOLID) )
+        continue;
+      int re = is_depth_exceeded(distances.get(pairs[k].first, dynamic_cast<Solid*>(p1)),
+                                 distances.get(pairs[k].second, dynamic_cast<Solid*>(p2)),
+                                 tol_overlap);
+      if (re != -1)
+      {
+        decided[k] = 1;
+        overlapping[k] = static_cast<char>(re);
+      }
     }
+  }
+  //-- 4. the Nefs (eroded if necessary) of the primitives in the other pairs
+  std::vector<Nef_polyhedron> lsNefs(lsPrims.size());
+  std::vector<bool> needed(lsPrims.size(), false);
+  for (std::size_t k = 0; k < pairs.size(); k++)
+  {
+    if (decided[k] == 0)
+      needed[pairs[k].first] = needed[pairs[k].second] = true;
+  }
+  for (int i = 0; i < lsPrims.size(); i++)
+  {
+    if (needed[i] == false)
+      continue;
+    if (tol_overlap > 0)
+      lsNefs[i] = get_eroded_nef(lsPrims[i], tol_overlap);
+    else if (lsPrims[i]->get_type() == SOLID) 
+      lsNefs[i] = *(dynamic_cast<Solid*>(lsPrims[i])->get_nef_polyhedron());
     else
+      lsNefs[i] = *(dynamic_cast<CompositeSolid*>(lsPrims[i])->get_nef_polyhedron());
+  }
+  //-- 5. check whether pairwise intersection of interiors is empty, the interior of 
+  //-- each Nef is computed once and the pairs can be tested by several threads
+  std::vector<Nef_polyhedron> interiors(lsNefs.size());
+  for (int i = 0; i < lsNefs.size(); i++)
+    if (needed[i] == true)
+      interiors[i] = lsNefs[i].interior();
+  std::vector<std::size_t> undecided;
+  for (std::size_t k = 0; k < pairs.size(); k++)
+  {
+    if (decided[k] == 0)
+      undecided.push_back(k);
+  }
+  std::atomic<std::size_t> next(0);
+  auto worker = [&]() {
+    for (std::size_t u = next++; u < undecided.size(); u = next++)
+    {
+      std::size_t k = undecided[u];
+      if ((interiors[pairs[k].first] * interiors[pairs[k].second]).is_empty() == false)
+        overlapping[k] = 1;
+    }
+  };
+  int nothreads = 1;
+  //-- the exact (lazy) kernel of the Nefs can be shared between threads only with 
+  //-- CGAL 5.5+ compiled with threads support
+#if defined(CGAL_HAS_THREADS) && (CGAL_VERSION_NR >= CGAL_VERSION_NUMBER(5,5,0))
+  nothreads = (_overlap_threads > 0) ? _overlap_threads : static_cast<int>(std::thread::hardware_concurrency());
+#endif
+  nothreads = std::max(1, std::min(nothreads, static_cast<int>(undecided.size())));
+  if (nothreads == 1)
+    worker();
+  else
+  {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nothreads; t++)
+      threads.emplace_back(worker);
+    for (auto& t : threads)
+      t.join();
+  }
+  for (std::size_t k = 0; k < pairs.size(); k++)
+  {
+    if (overlapping[k] == 1)
+    {
+      Error e;
+      std::stringstream msg;
+      msg << lsPrims[pairs[k].first]->get_id() << "&&" << lsPrims[pairs[k].second]->get_id();
+      e.errorcode = errorcode_to_assign;
+      e.info1 = msg.str();
+      e.info2 = "";
+      lsErrors.push_back(e);
+      isValid = false;
+    }
+  }
+  return !isValid;
+}
+
+
+//-- do the interiors of 2 solids overlap? Their meshes are corefined (on copies) and 
+//-- the volume of their intersection is computed. With a tolerance, eroding both solids 
+//-- by tol_overlap (as with the Nefs) is eroding their intersection: it must contain a 
+//-- cube of side 2 * tol_overlap, impossible if its volume is smaller. Otherwise only the 
+//-- Nefs can tell (the shape of the intersection matters, not only its volume)
+//-------------
+// -1: cannot be decided (the intersection is not a closed mesh, or it is large enough)
+//  0: not overlapping
+//  1: overlapping
+static int do_meshes_interior_overlap(const SurfaceMesh& m1, double vol1,
+                                      const SurfaceMesh& m2, double vol2,
+                                      double tol_overlap)
+{
+  //-- one inside the other is also an intersection
+  if (PMP::do_intersect(m1, m2, 
+                        CGAL::parameters::do_overlap_test_of_bounded_sides(true),
+                        CGAL::parameters::do_overlap_test_of_bounded_sides(true)) == false)
+    return 0;
+  SurfaceMesh c1(m1);
+  SurfaceMesh c2(m2);
+  SurfaceMesh inter;
+  if (PMP::corefine_and_compute_intersection(c1, c2, inter) == false)
+    return -1;
+  if (inter.number_of_faces() == 0)
+    return 0;
+  double vol = CGAL::to_double(PMP::volume(inter));
+  //-- touching solids have a (numerically) empty intersection
+  if (vol <= (1e-9 * std::min(vol1, vol2)))
+    return 0;
+  if (tol_overlap <= 0.0)
+    return 1;
+  if (vol <= (8 * tol_overlap * tol_overlap * tol_overlap))
+    return 0;
+  return -1;
+}
+
+
+void find_solids_interior_overlap_corefinement(std::vector<Solid*>& lsSolids,
+                                               std::vector<std::pair<int, int>>& overlaps,
+                                               double tol_overlap)
+{
+  //-- 1. only the pairs whose bboxes intersect are tested
+  std::vector<CGAL::Bbox_3> bboxes;
+  for (auto& s : lsSolids)
+    bboxes.push_back(s->get_bbox());
+  std::vector<std::pair<int, int>> pairs = get_intersecting_bboxes(bboxes);
+  //-- 2. the meshes (and their volume) of the solids in the pairs
+  std::vector<SurfaceMesh> meshes(lsSolids.size());
+  std::vector<double> volumes(lsSolids.size(), 0.0);
+  std::vector<bool> needed(lsSolids.size(), false);
+  for (auto& pr : pairs)
+    needed[pr.first] = needed[pr.second] = true;
+  for (int i = 0; i < lsSolids.size(); i++)
+  {
+    if (needed[i] == true)
     {
-      lsNefs.push_back(tmpnef);
+      meshes[i] = get_solid_mesh(lsSolids[i]);
+      volumes[i] = CGAL::to_double(PMP::volume(meshes[i]));
     }
   }
-  //-- 2. check whether pairwise intersection of interiors is empty
+  //-- 3. test the pairs, the Nefs are used for those that cannot be decided
   Nef_polyhedron emptynef(Nef_polyhedron::EMPTY);
-  for (int i = 0; i < lsNefs.size(); i++)
+  for (auto& pr : pairs)
+  {
+    int re = do_meshes_interior_overlap(meshes[pr.first], volumes[pr.first],
+                                        meshes[pr.second], volumes[pr.second],
+                                        tol_overlap);
+    if ( (re == -1) && (tol_overlap > 0.0) )
+      re = do_primitives_interior_overlap_nef(lsSolids[pr.first], lsSolids[pr.second], tol_overlap, false) ? 1 : 0;
+    else if (re == -1)
+      re = (lsSolids[pr.first]->get_nef_polyhedron()->interior() * 
+            lsSolids[pr.second]->get_nef_polyhedron()->interior() != emptynef) ? 1 : 0;
+    if (re == 1)
+      overlaps.push_back(pr);
+  }
+}
+
+
+void find_solids_interior_overlap_distances(std::vector<Solid*>& lsSolids,
+                                            std::vector<std::pair<int, int>>& overlaps,
+                                            double tol_overlap)
+{
+  std::vector<CGAL::Bbox_3> bboxes;
+  for (auto& s : lsSolids)
+    bboxes.push_back(s->get_bbox());
+  SolidDistances distances(lsSolids.size());
+  for (auto& pr : get_intersecting_bboxes(bboxes))
+  {
+    int re = is_depth_exceeded(distances.get(pr.first, lsSolids[pr.first]),
+                               distances.get(pr.second, lsSolids[pr.second]),
+                               tol_overlap);
+    if (re == -1)
+      re = do_primitives_interior_overlap_nef(lsSolids[pr.first], lsSolids[pr.second], tol_overlap, false) ? 1 : 0;
+    if (re == 1)
+      overlaps.push_back(pr);
+  }
+}
+
+
+//-- the triangles of all the shells of a Solid
+static std::vector<Triangle> get_solid_triangles(Solid* s)
+{
+  std::vector<Triangle> re;
+  for (auto& sh : s->get_shells())
+  {
+    CgalPolyhedron* p = sh->get_cgal_polyhedron();
+    for (auto f = p->facets_begin(); f != p->facets_end(); f++)
+    {
+      auto h = f->facet_begin();
+      re.push_back(Triangle(h->vertex()->point(), 
+                            h->next()->vertex()->point(), 
+                            h->next()->next()->vertex()->point()));
+    }
+  }
+  return re;
+}
+
+
+//-- do 2 triangles share a part of their surface? They must be coplanar and, once 
+//-- projected to 2D, not be separated by the line of one of their edges. Only exact 
+//-- predicates are used (the projection drops one coordinate)
+static bool do_triangles_share_area(const Triangle& t1, const Triangle& t2)
+{
+  for (int i = 0; i < 3; i++)
   {
-    Nef_polyhedron* a = lsNefs[i];
-    for (int j = i + 1; j < lsNefs.size(); j++) 
+    if (CGAL::coplanar(t1[0], t1[1], t1[2], t2[i]) == false)
+      return false;
+  }
+  Vector n = CGAL::cross_product(t1[1] - t1[0], t1[2] - t1[0]);
+  int axis = 2;
+  if ( (std::abs(n.x()) >= std::abs(n.y())) && (std::abs(n.x()) >= std::abs(n.z())) )
+    axis = 0;
+  else if (std::abs(n.y()) >= std::abs(n.z()))
+    axis = 1;
+  std::array<Point2, 3> a, b;
+  for (int i = 0; i < 3; i++)
+  {
+    a[i] = Point2(t1[i][(axis + 1) % 3], t1[i][(axis + 2) % 3]);
+    b[i] = Point2(t2[i][(axis + 1) % 3], t2[i][(axis + 2) % 3]);
+  }
+  if ( (CGAL::orientation(a[0], a[1], a[2]) == CGAL::COLLINEAR) || 
+       (CGAL::orientation(b[0], b[1], b[2]) == CGAL::COLLINEAR) )
+    return false;
+  if (CGAL::orientation(a[0], a[1], a[2]) == CGAL::CLOCKWISE)
+    std::swap(a[1], a[2]);
+  if (CGAL::orientation(b[0], b[1], b[2]) == CGAL::CLOCKWISE)
+    std::swap(b[1], b[2]);
+  auto separated = [](const std::array<Point2, 3>& x, const std::array<Point2, 3>& y) {
+    for (int i = 0; i < 3; i++)
     {
-      Nef_polyhedron* b = lsNefs[j];
-      if (a->interior() * b->interior() != emptynef)
+      bool allright = true;
+      for (int j = 0; j < 3; j++)
       {
-        Error e;
-        std::stringstream msg;
-        msg << lsPrimitives[i]->get_id() << "&&" << lsPrimitives[j]->get_id();
-        e.errorcode = errorcode_to_assign;
-        e.info1 = msg.str();
-        e.info2 = "";
-        lsErrors.push_back(e);
-        isValid = false;
+        if (CGAL::orientation(x[i], x[(i + 1) % 3], y[j]) == CGAL::LEFT_TURN)
+        {
+          allright = false;
+          break;
+        }
       }
+      if (allright == true)
+        return true;
     }
+    return false;
+  };
+  return ( (separated(a, b) == false) && (separated(b, a) == false) );
+}
+
+
+//-- are 2 solids in contact along a surface (not only an edge or a vertex)? Only the 
+//-- pairs of triangles whose bboxes intersect are tested
+static bool are_solids_face_adjacent(const std::vector<Triangle>& t1, const std::vector<Triangle>& t2)
+{
+  std::vector<AABBid> b1, b2;
+  for (int i = 0; i < t1.size(); i++)
+    b1.push_back(AABBid(t1[i].bbox(), i));
+  for (int i = 0; i < t2.size(); i++)
+    b2.push_back(AABBid(t2[i].bbox(), i));
+  bool adjacent = false;
+  CGAL::box_intersection_d(b1.begin(), b1.end(), b2.begin(), b2.end(), [&](const AABBid& a, const AABBid& b) {
+    if ( (adjacent == false) && (do_triangles_share_area(t1[a.info()], t2[b.info()]) == true) )
+      adjacent = true;
+  });
+  return adjacent;
+}
+
+
+static int find_root(std::vector<int>& parent, int x)
+{
+  while (parent[x] != x)
+  {
+    parent[x] = parent[parent[x]];
+    x = parent[x];
   }
-  if (tol_overlap > 0.0)
+  return x;
+}
+
+
+//-- number of components of the boundary of the union of (valid and interior-disjoint)
+//-- solids, without computing it: the coplanar triangles of a solid in contact with 
+//-- other solids are grouped in patches, each must have the same boundary edges as a 
+//-- patch of another solid (the same region is shared), and then the triangles left 
+//-- are the boundary of the union, their components are found through their edges.
+//-- -1 if it cannot be told: a contact covers only a part of a face, or an edge is 
+//-- used by more than 2 of the triangles left
+static int get_number_components_unshared(std::vector<std::vector<Triangle>>& triangles)
+{
+  typedef std::pair<Point3, Point3> Edge;
+  std::vector<Triangle> tris;
+  std::vector<int> owner;
+  for (int i = 0; i < triangles.size(); i++)
   {
-    for (auto each : lsNefs)
-      delete each;
+    for (auto& t : triangles[i])
+    {
+      tris.push_back(t);
+      owner.push_back(i);
+    }
   }
-  return !isValid;
+  int nt = static_cast<int>(tris.size());
+  //-- 1. the triangles sharing an area with a triangle of another solid
+  std::vector<bool> contact(nt, false);
+  std::vector<AABBid> aabbs;
+  for (int i = 0; i < nt; i++)
+    aabbs.push_back(AABBid(tris[i].bbox(), i));
+  CGAL::box_self_intersection_d(aabbs.begin(), aabbs.end(), [&](const AABBid& a, const AABBid& b) {
+    int ta = a.info();
+    int tb = b.info();
+    if ( (owner[ta] != owner[tb]) && (do_triangles_share_area(tris[ta], tris[tb]) == true) )
+    {
+      contact[ta] = true;
+      contact[tb] = true;
+    }
+  });
+  //-- 2. the triangles of each edge
+  std::map<Edge, std::vector<int>> edges;
+  for (int i = 0; i < nt; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      Point3 a = tris[i][j];
+      Point3 b = tris[i][(j + 1) % 3];
+      if (b < a)
+        std::swap(a, b);
+      edges[std::make_pair(a, b)].push_back(i);
+    }
+  }
+  //-- 3. the patches (union-find), and their boundary edges (sorted since the map is)
+  std::vector<int> parent(nt);
+  for (int i = 0; i < nt; i++)
+    parent[i] = i;
+  for (auto& e : edges)
+  {
+    for (int i = 0; i < e.second.size(); i++)
+    {
+      int t = e.second[i];
+      for (int j = i + 1; j < e.second.size(); j++)
+      {
+        int u = e.second[j];
+        if ( (contact[t] == true) && (contact[u] == true) && (owner[t] == owner[u]) &&
+             (CGAL::coplanar(tris[t][0], tris[t][1], tris[t][2], tris[u][0]) == true) &&
+             (CGAL::coplanar(tris[t][0], tris[t][1], tris[t][2], tris[u][1]) == true) &&
+             (CGAL::coplanar(tris[t][0], tris[t][1], tris[t][2], tris[u][2]) == true) )
+          parent[find_root(parent, t)] = find_root(parent, u);
+      }
+    }
+  }
+  std::map<int, std::vector<Edge>> boundaries;
+  for (auto& e : edges)
+  {
+    std::map<int, int> count;
+    for (auto t : e.second)
+    {
+      if (contact[t] == true)
+        count[find_root(parent, t)]++;
+    }
+    for (auto& c : count)
+    {
+      if (c.second == 1)
+        boundaries[c.first].push_back(e.first);
+    }
+  }
+  std::map<std::vector<Edge>, std::set<int>> patches;
+  for (auto& b : boundaries)
+    patches[b.second].insert(owner[b.first]);
+  for (auto& p : patches)
+  {
+    if (p.second.size() < 2)
+      return -1;
+  }
+  //-- 4. the components of the triangles left (not in contact, so not in a patch)
+  for (auto& e : edges)
+  {
+    std::vector<int> left;
+    for (auto t : e.second)
+    {
+      if (contact[t] == false)
+        left.push_back(t);
+    }
+    if (left.size() > 2)
+      return -1;
+    if (left.size() == 2)
+      parent[find_root(parent, left[0])] = find_root(parent, left[1]);
+  }
+  int nocomponents = 0;
+  for (int i = 0; i < nt; i++)
+  {
+    if ( (contact[i] == false) && (find_root(parent, i) == i) )
+      nocomponents++;
+  }
+  return nocomponents;
+}
+
+
+//-- number of shells of the union of (valid and non-overlapping) solids, with the 
+//-- corefinement of their meshes (exact constructions) merged 2 by 2: for solids in 
+//-- contact each shell other than the outer one bounds a void. -1 if it cannot be 
+//-- computed (eg a mesh self-intersects or the union is not 2-manifold)
+static int get_number_shells_union(std::vector<Solid*>& lsSolids)
+{
+  std::vector<SurfaceMeshE> meshes(lsSolids.size());
+  for (int i = 0; i < lsSolids.size(); i++)
+  {
+    for (auto& sh : lsSolids[i]->get_shells())
+      CGAL::copy_face_graph(*(sh->get_cgal_polyhedron()), meshes[i]);
+  }
+  try
+  {
+    while (meshes.size() > 1)
+    {
+      std::vector<SurfaceMeshE> merged;
+      for (std::size_t i = 0; (i + 1) < meshes.size(); i += 2)
+      {
+        if (PMP::corefine_and_compute_union(meshes[i], meshes[i + 1], meshes[i],
+                                            CGAL::parameters::throw_on_self_intersection(true),
+                                            CGAL::parameters::throw_on_self_intersection(true)) == false)
+          return -1;
+        merged.push_back(std::move(meshes[i]));
+      }
+      if ((meshes.size() % 2) == 1)
+        merged.push_back(std::move(meshes.back()));
+      meshes.swap(merged);
+    }
+  }
+  catch (const PMP::Corefinement::Self_intersection_exception&)
+  {
+    return -1;
+  }
+  auto fcc = meshes[0].add_property_map<SurfaceMeshE::Face_index, std::size_t>("f:cc", 0).first;
+  return static_cast<int>(PMP::connected_components(meshes[0], fcc));
+}
+
+
+//-- number of parts formed by the union of the (valid and non-overlapping) solids: 
+//-- the connected components of the graph whose edges are the solids in contact along
+//-- a surface. With a tolerance, the solids whose dilations overlap are also in 
+//-- contact: this is tested (with distances or the Nefs) only for the pairs not in 
+//-- contact already. Like with the union of the Nefs, a void enclosed by the solids
+//-- counts as one more part
+int get_number_connected_solids(std::vector<Solid*>& lsSolids, double tol_overlap)
+{
+  int n = static_cast<int>(lsSolids.size());
+  double d = (tol_overlap > 0.0) ? tol_overlap : 0.0;
+  //-- 1. candidate pairs: their bboxes (enlarged by the tolerance) intersect
+  std::vector<CGAL::Bbox_3> bboxes;
+  std::vector<CGAL::Bbox_3> enlarged;
+  for (int i = 0; i < n; i++)
+  {
+    CGAL::Bbox_3 b = lsSolids[i]->get_bbox();
+    bboxes.push_back(b);
+    enlarged.push_back(CGAL::Bbox_3(b.xmin() - d, b.ymin() - d, b.zmin() - d,
+                                    b.xmax() + d, b.ymax() + d, b.zmax() + d));
+  }
+  std::vector<std::pair<int, int>> pairs = get_intersecting_bboxes(enlarged);
+  //-- 2. union-find, the pairs already in the same component are not tested
+  std::vector<int> parent(n);
+  for (int i = 0; i < n; i++)
+    parent[i] = i;
+  std::vector<std::vector<Triangle>> triangles(n);
+  std::vector<Nef_polyhedron> dilated(n);
+  std::vector<bool> isdilated(n, false);
+  SolidDistances distances(n);
+  Nef_polyhedron emptynef(Nef_polyhedron::EMPTY);
+  for (auto& pr : pairs)
+  {
+    int ra = find_root(parent, pr.first);
+    int rb = find_root(parent, pr.second);
+    if (ra == rb)
+      continue;
+    bool adjacent = false;
+    if (CGAL::do_overlap(bboxes[pr.first], bboxes[pr.second]) == true)
+    {
+      for (auto i : {pr.first, pr.second})
+      {
+        if (triangles[i].empty() == true)
+          triangles[i] = get_solid_triangles(lsSolids[i]);
+      }
+      adjacent = are_solids_face_adjacent(triangles[pr.first], triangles[pr.second]);
+    }
+    if ( (adjacent == false) && (tol_overlap > 0.0) )
+    {
+      int re = -1;
+      if (_overlap_distances == true)
+        re = is_depth_exceeded(distances.get(pr.first, lsSolids[pr.first]),
+                               distances.get(pr.second, lsSolids[pr.second]),
+                               -tol_overlap);
+      if (re == -1)
+      {
+        for (auto i : {pr.first, pr.second})
+        {
+          if (isdilated[i] == false)
+          {
+            dilated[i] = lsSolids[i]->get_dilated_nef_polyhedron(tol_overlap);
+            isdilated[i] = true;
+          }
+        }
+        re = (dilated[pr.first].interior() * dilated[pr.second].interior() != emptynef) ? 1 : 0;
+      }
+      adjacent = (re == 1);
+    }
+    if (adjacent == true)
+      parent[ra] = rb;
+  }
+  int noparts = 0;
+  for (int i = 0; i < n; i++)
+  {
+    if (find_root(parent, i) == i)
+      noparts++;
+  }
+  //-- 3. the union of the solids of one part must not enclose a void. Without a 
+  //-- tolerance the solids are interior-disjoint: if the faces they do not share form
+  //-- one component there is none. Otherwise the union of the meshes, and that of the 
+  //-- Nefs when the meshes cannot, or with a tolerance if there is a void (the dilation
+  //-- closes the voids thinner than it)
+  if (noparts == 1)
+  {
+    int noshells = -1;
+    if (tol_overlap <= 0.0)
+    {
+      for (int i = 0; i < n; i++)
+      {
+        if (triangles[i].empty() == true)
+          triangles[i] = get_solid_triangles(lsSolids[i]);
+      }
+      noshells = get_number_components_unshared(triangles);
+    }
+    if (noshells != 1)
+      noshells = get_number_shells_union(lsSolids);
+    if ( (noshells == -1) || ((noshells > 1) && (tol_overlap > 0.0)) )
+    {
+      Nef_polyhedron unioned(Nef_polyhedron::EMPTY);
+      for (int i = 0; i < n; i++)
+      {
+        if (tol_overlap <= 0.0)
+          unioned = unioned + *(lsSolids[i]->get_nef_polyhedron());
+        else
+        {
+          if (isdilated[i] == false)
+          {
+            dilated[i] = lsSolids[i]->get_dilated_nef_polyhedron(tol_overlap);
+            isdilated[i] = true;
+          }
+          unioned = unioned + dilated[i];
+        }
+      }
+      noshells = static_cast<int>(unioned.number_of_volumes()) - 1;
+    }
+    noparts = noshells;
+  }
+  return noparts;
 }
 
 
@@ -218,36 +1061,48 @@ int are_primitives_adjacent(Primitive* p1,
   if ( (p1->is_valid() != 1) || (p2->is_valid() != 1) )
     return -1;
 
-  Nef_polyhedron emptynef(Nef_polyhedron::EMPTY);
-  Nef_polyhedron* n1;
-  Nef_polyhedron* n2;
-  if (p1->get_type() == SOLID)
-    n1 = dynamic_cast<Solid*>(p1)->get_nef_polyhedron();
-  else if (p1->get_type() == COMPOSITESOLID)
-    n1 = dynamic_cast<CompositeSolid*>(p1)->get_nef_polyhedron();
-  if (p2->get_type() == SOLID)
-    n2 = dynamic_cast<Solid*>(p2)->get_nef_polyhedron();
-  else if (p2->get_type() == COMPOSITESOLID)
-    n2 = dynamic_cast<CompositeSolid*>(p2)->get_nef_polyhedron();
-
   if (tol_overlap < 0.0)
   {
+    Nef_polyhedron emptynef(Nef_polyhedron::EMPTY);
+    Nef_polyhedron* n1;
+    Nef_polyhedron* n2;
+    if (p1->get_type() == SOLID)
+      n1 = dynamic_cast<Solid*>(p1)->get_nef_polyhedron();
+    else if (p1->get_type() == COMPOSITESOLID)
+      n1 = dynamic_cast<CompositeSolid*>(p1)->get_nef_polyhedron();
+    if (p2->get_type() == SOLID)
+      n2 = dynamic_cast<Solid*>(p2)->get_nef_polyhedron();
+    else if (p2->get_type() == COMPOSITESOLID)
+      n2 = dynamic_cast<CompositeSolid*>(p2)->get_nef_polyhedron();
     if (n1->boundary() * n2->boundary() != emptynef)
       return 1;
     else
       return 0;
   }
+  else if ( (tol_overlap > 0.0) && (_overlap_distances == true) && 
+            (p1->get_type() == SOLID) && (p2->get_type() == SOLID) )
+  {
+    SolidDistance d1(dynamic_cast<Solid*>(p1));
+    SolidDistance d2(dynamic_cast<Solid*>(p2));
+    //-- 1. the eroded solids do not overlap
+    int re = is_depth_exceeded(d1, d2, tol_overlap);
+    if (re == -1)
+      re = do_primitives_interior_overlap_nef(p1, p2, tol_overlap, false) ? 1 : 0;
+    if (re == 1)
+      return 0;
+    //-- 2. the dilated solids overlap
+    re = is_depth_exceeded(d1, d2, -tol_overlap);
+    if (re == -1)
+      re = do_primitives_interior_overlap_nef(p1, p2, tol_overlap, true) ? 1 : 0;
+    return re;
+  }
   else 
   {
     //-- 1. erode the nefs
-    Nef_polyhedron* ne1 = erode_nef_polyhedron(n1, tol_overlap);
-    Nef_polyhedron* ne2 = erode_nef_polyhedron(n2, tol_overlap);
-    if (ne1->interior() * ne2->interior() != emptynef)
+    if (do_primitives_interior_overlap_nef(p1, p2, tol_overlap, false) == true)
       return 0;
     //-- 2. dilate the Nefs
-    Nef_polyhedron* nd1 = dilate_nef_polyhedron(n1, tol_overlap);
-    Nef_polyhedron* nd2 = dilate_nef_polyhedron(n2, tol_overlap);
-    if (nd1->interior() * nd2->interior() == emptynef)
+    if (do_primitives_interior_overlap_nef(p1, p2, tol_overlap, true) == false)
       return 0;
     return 1;
   }
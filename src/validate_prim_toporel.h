@@ -48,8 +48,23 @@ bool are_cells_interior_disconnected_with_aabb(std::vector<std::tuple<std::strin
                                                std::vector<Error>& lsErrors, 
                                                double tol_overlap);
 
+void find_solids_interior_overlap_corefinement(std::vector<Solid*>& lsSolids,
+                                               std::vector<std::pair<int, int>>& overlaps,
+                                               double tol_overlap);
+
+void find_solids_interior_overlap_distances(std::vector<Solid*>& lsSolids,
+                                            std::vector<std::pair<int, int>>& overlaps,
+                                            double tol_overlap);
+
+int get_number_connected_solids(std::vector<Solid*>& lsSolids, double tol_overlap);
+
 int are_primitives_adjacent(Primitive* p1, Primitive* p2, double tol_overlap);
 
+void set_overlap_threads(int threads);
+
+void set_overlap_tol_with_distances(bool distances);
+bool get_overlap_tol_with_distances();
+
 
 
 } // namespace val3dity
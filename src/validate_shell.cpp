@@ -43,7 +43,7 @@ typedef CgalPolyhedron::Facet_const_iterator    Facet_const_iterator;
 typedef CgalPolyhedron::Facet_const_handle      Facet_const_handle;
 
 
-CgalPolyhedron* construct_CgalPolyhedron_incremental(std::vector< std::vector<int*> > *lsTr, std::vector<Point3> *lsPts, Surface* sh)
+CgalPolyhedron* construct_CgalPolyhedron_incremental(const TriangulatedFaces *lsTr, std::vector<Point3> *lsPts, Surface* sh)
 {
   CgalPolyhedron* P = new CgalPolyhedron();
   ConstructShell<HalfedgeDS> s(lsTr, lsPts, sh);
@@ -65,7 +65,7 @@ void ConstructShell<HDS>::operator()( HDS& hds)
   typedef typename HDS::Face_handle     FaceH;
   typedef typename HDS::Halfedge_handle heH;
   CGAL::Polyhedron_incremental_builder_3<HDS> B(hds, false);
-  B.begin_surface((*lsPts).size(), (*faces).size());
+  B.begin_surface((*lsPts).size(), faces->number_triangles());
   std::vector<Point3>::const_iterator itPt = lsPts->begin();
   for ( ; itPt != lsPts->end(); itPt++)
   { 
@@ -85,17 +85,10 @@ void ConstructShell<HDS>::operator()( HDS& hds)
 template <class HDS>
 void ConstructShell<HDS>::construct_faces_order_given(CGAL::Polyhedron_incremental_builder_3<HDS>& B)
 {
-  std::vector< std::vector<int*> >::const_iterator itF = faces->begin();
-  int faceID = 0;
-  for ( ; itF != faces->end(); itF++)
+  for (std::size_t faceID = 0; faceID < faces->number_faces(); faceID++)
   {
-    std::vector<int*>::const_iterator itF2 = itF->begin();
-    for ( ; itF2 != itF->end(); itF2++)
-    {
-      int* a = *itF2;
-      add_one_face(B, a[0], a[1], a[2], std::to_string(faceID));
-    }
-    faceID++;
+    for (const TriangleIds* a = faces->face_begin(faceID); a != faces->face_end(faceID); a++)
+      add_one_face(B, (*a)[0], (*a)[1], (*a)[2], std::to_string(faceID));
   }
 }
 
@@ -119,19 +112,11 @@ void ConstructShell<HDS>::construct_faces_flip_when_possible(CGAL::Polyhedron_in
     halfedges[i] = false;
   
   //-- build one flat list of the triangular faces, for convenience
-  list<int*> trFaces;
-  std::vector< std::vector<int*> >::const_iterator itF = faces->begin();
-  for ( ; itF != faces->end(); itF++)
-  {
-    std::vector<int*>::const_iterator itF2 = itF->begin();
-    for ( ; itF2 != itF->end(); itF2++)
-    {
-      int* a = *itF2;
-      trFaces.push_back(a);
-    }
-  }
+  list<const int*> trFaces;
+  for (auto& t : faces->tris)
+    trFaces.push_back(t.data());
   //-- start with the first one
-  int* a = trFaces.front();
+  const int* a = trFaces.front();
   std::vector< std::size_t> faceids(3);        
   faceids[0] = a[0];
   faceids[1] = a[1];
@@ -172,12 +157,12 @@ void ConstructShell<HDS>::construct_faces_flip_when_possible(CGAL::Polyhedron_in
 
 
 template <class HDS>
-bool ConstructShell<HDS>::try_to_add_face(CGAL::Polyhedron_incremental_builder_3<HDS>& B, list<int*>& trFaces, bool* halfedges, bool bMustBeConnected)
+bool ConstructShell<HDS>::try_to_add_face(CGAL::Polyhedron_incremental_builder_3<HDS>& B, list<const int*>& trFaces, bool* halfedges, bool bMustBeConnected)
 {
   bool success = false;
-  for (list<int*>::iterator it1 = trFaces.begin(); it1 != trFaces.end(); it1++)
+  for (list<const int*>::iterator it1 = trFaces.begin(); it1 != trFaces.end(); it1++)
   {
-    int* a = *it1;
+    const int* a = *it1;
     std::vector< std::size_t> faceids(3);
     faceids[0] = a[0];
     faceids[1] = a[1];
@@ -217,7 +202,7 @@ bool ConstructShell<HDS>::try_to_add_face(CGAL::Polyhedron_incremental_builder_3
 
 
 template <class HDS>
-bool ConstructShell<HDS>::is_connected(int* tr, bool* halfedges)
+bool ConstructShell<HDS>::is_connected(const int* tr, bool* halfedges)
 {
   if ( (halfedges[m2a(tr[1],tr[0])] == true) ||
        (halfedges[m2a(tr[2],tr[1])] == true) ||
@@ -259,29 +244,18 @@ bool check_global_orientation_normals(CgalPolyhedron* p, bool bOuter)
 }
 
 
-CgalPolyhedron* construct_CgalPolyhedron_batch(const std::vector< std::vector<int*> >&lsTr, const std::vector<Point3>& lsPts)
+CgalPolyhedron* construct_CgalPolyhedron_batch(const TriangulatedFaces& lsTr, const std::vector<Point3>& lsPts)
 {
   //-- construct the 2-manifold, using the "batch" way
   stringstream offrep (stringstream::in | stringstream::out);
-  std::vector< std::vector<int*> >::const_iterator it = lsTr.begin();
-  size_t noFaces = 0;
-  for ( ; it != lsTr.end(); it++)
-    noFaces += it->size();
-  offrep << "OFF" << endl << lsPts.size() << " " << noFaces << " 0" << endl;
+  offrep << "OFF" << endl << lsPts.size() << " " << lsTr.number_triangles() << " 0" << endl;
 
   std::vector<Point3>::const_iterator itPt = lsPts.begin();
   for ( ; itPt != lsPts.end(); itPt++)
     offrep << *itPt << endl;
 
-  for (it = lsTr.begin(); it != lsTr.end(); it++)
-  {
-    std::vector<int*>::const_iterator it2 = it->begin();
-    for ( ; it2 != it->end(); it2++)
-    {
-      int* tmp = *it2;
-      offrep << "3 " << tmp[0] << " " << tmp[1] << " " << tmp[2] << endl;
-    }
-  }
+  for (auto& tmp : lsTr.tris)
+    offrep << "3 " << tmp[0] << " " << tmp[1] << " " << tmp[2] << endl;
   CgalPolyhedron* P = new CgalPolyhedron();
   offrep >> *P;
   return P;
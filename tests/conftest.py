@@ -1,6 +1,7 @@
 import pytest
 import subprocess
 import os.path
+import json
 import sys
 
 #------------------------- use concurrent test execution if xdist is installed
@@ -152,6 +153,16 @@ def solid():
     """val3dity options for validating a Solid"""
     return(["--unittests", "-p Solid"])
 
+@pytest.fixture(scope="session")
+def solid_geos():
+    """val3dity options for validating a Solid, with GEOS for the 2D validation"""
+    return(["--unittests", "-p Solid", "--geos"])
+
+@pytest.fixture(scope="session")
+def corefinement():
+    """val3dity options for validating a file, with corefinement for the overlap of solids"""
+    return(["--unittests", "--corefinement"])
+
 @pytest.fixture(scope="session")
 def compositesurface():
     """val3dity options for validating a CompositeSurface"""
@@ -227,6 +238,39 @@ def validate(val3dity):
     return(_validate)
 
 
+@pytest.fixture(scope="session")
+def validate_errors(val3dity, tmp_path_factory):
+    def _validate(file_path, options=unittests, val3dity=val3dity):
+        """Validate a file and read its errors in the report
+
+        :return: The (code, face) of the errors of the first feature, in the 
+                 order of the report. face is the id of the face, if any.
+        :rtype: list
+        """
+        report = str(tmp_path_factory.mktemp("report") / "report.json")
+        command = [val3dity] + options + ["--report", report, file_path]
+        try:
+            subprocess.run(command,
+                           stdout=subprocess.PIPE,
+                           stderr=subprocess.PIPE,
+                           universal_newlines=True,
+                           timeout=15)
+        except subprocess.TimeoutExpired:
+            return([" ".join(["Something went really wrong.",
+                             "Validate the file separately with val3dity.",
+                             "Or set a higher timeout in conftest.py."])])
+        if os.path.exists(report) == False:
+            return(["CRASH"])
+        with open(report) as f:
+            j = json.load(f)
+        output = []
+        for e in j["features"][0]["errors"]:
+            output.append((e["code"], e["id"].split("face=")[-1]))
+        return(output)
+
+    return(_validate)
+
+
 @pytest.fixture(scope="session")
 def validate_full():
     """Validate a file and return the full stdout, stderr
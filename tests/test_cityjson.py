@@ -94,3 +94,15 @@ def test_empty_geom(validate, data_empty_geom, unittests):
 def test_versions(validate, data_versions, unittests):
     error = validate(data_versions, options=unittests)
     assert(error == [])
+
+def test_invalid_geomtemplates_stream(validate, data_cj_iv_gt, unittests):
+    error = validate(data_cj_iv_gt, options=unittests + ["--stream"])
+    assert(error == [203])
+
+def test_cityjson_v11_stream(validate, data_cj_v11, unittests):
+    error = validate(data_cj_v11, options=unittests + ["--stream"])
+    assert(error == [])
+
+def test_empty_geom_stream(validate, data_empty_geom, unittests):
+    error = validate(data_empty_geom, options=unittests + ["--stream"])
+    assert(error == [906])
@@ -2,6 +2,7 @@
 """
 import pytest
 import os.path
+import subprocess
 
 #------------------------------------------------------------------------ Data
 @pytest.fixture(scope="module",
@@ -22,6 +23,35 @@ def data_2(request, dir_cityjsonl):
             request.param))
     return([file_path])
 
+@pytest.fixture(scope="module",
+                params=["wrong_structure.jsonl"])
+def data_3(request, dir_cityjsonl):
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_cityjsonl,
+            request.param))
+    return([file_path])
+
+
+
+@pytest.fixture(scope="module")
+def data_stdin(dir_cityjsonl):
+    """a CityJSONSeq stream with an invalid CityJSONFeature and an invalid JSON line"""
+    file_path = os.path.join(dir_cityjsonl, "wrong_structure.jsonl")
+    with open(file_path) as f:
+        lines = f.read().splitlines()
+    lines.insert(3, "{this is not JSON")
+    return("\n".join(lines) + "\n")
+
+def validate_stdin(val3dity, stream, options):
+    proc = subprocess.run([val3dity, "stdin"] + options,
+                          input=stream,
+                          stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE,
+                          universal_newlines=True,
+                          timeout=15)
+    return(proc.stdout.splitlines())
+
 
 
 #----------------------------------------------------------------------- Tests
@@ -33,3 +63,28 @@ def test_data_2_cityjsonl(validate, data_2, unittests):
     error = validate(data_2, options=unittests)
     assert(error == [901])
 
+def test_data_3_cityjsonl(validate, data_3, unittests):
+    error = validate(data_3, options=unittests)
+    assert(error == [901])
+
+
+def test_data_1_cityjsonl_jobs(validate, data_1, unittests):
+    error = validate(data_1, options=unittests + ["--jobs", "4"])
+    assert(error == [203, 601])
+
+def test_data_2_cityjsonl_jobs(validate, data_2, unittests):
+    error = validate(data_2, options=unittests + ["--jobs", "4"])
+    assert(error == [901])
+
+def test_data_3_cityjsonl_jobs(validate, data_3, unittests):
+    error = validate(data_3, options=unittests + ["--jobs", "4"])
+    assert(error == [901])
+
+
+def test_stdin(val3dity, data_stdin):
+    out = validate_stdin(val3dity, data_stdin, [])
+    assert(out == ['"" []', '"b1" []', '"b2" [901]', 'line.4 [905]', '"b3" []'])
+
+def test_stdin_jobs(val3dity, data_stdin):
+    out = validate_stdin(val3dity, data_stdin, ["--jobs", "2"])
+    assert(out == ['"" []', '"b1" []', '"b2" [901]', 'line.4 [905]', '"b3" []'])
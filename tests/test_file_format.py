@@ -57,6 +57,18 @@ def data_invalid_obj(request, dir_file_format):
     return([file_path])
 
 
+@pytest.fixture(scope="module",
+                params=["invalid_poly_1.poly",
+                        "invalid_poly_2.poly",
+                        "invalid_poly_3.poly"])
+def data_invalid_poly(request, dir_file_format):
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_file_format,
+            request.param))
+    return([file_path])
+
+
 #----------------------------------------------------------------------- Tests
 
 
@@ -75,3 +87,7 @@ def test_invalid_indoorgml(validate, data_invalid_indoorgml, unittests):
 def test_invalid_obj(validate, data_invalid_obj, unittests):
     error = validate(data_invalid_obj, options=unittests)
     assert(error == [901])    
+
+def test_invalid_poly(validate, data_invalid_poly, unittests):
+    error = validate(data_invalid_poly, options=unittests)
+    assert(error == [901])
@@ -233,6 +233,51 @@ def data_307_1(request, dir_geometry_generic):
             request.param))
     return(file_path)
 
+@pytest.fixture(scope="module",
+                params=["302_3.poly"])
+def data_302_3(request, dir_geometry_generic):
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_generic,
+            request.param))
+    return(file_path)
+
+@pytest.fixture(scope="module",
+                params=["303_302.poly"])
+def data_303_302(request, dir_geometry_generic):
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_generic,
+            request.param))
+    return(file_path)
+
+@pytest.fixture(scope="module",
+                params=["305_302.poly"])
+def data_305_302(request, dir_geometry_generic):
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_generic,
+            request.param))
+    return(file_path)
+
+@pytest.fixture(scope="module",
+                params=["307_2.poly"])
+def data_307_2(request, dir_geometry_generic):
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_generic,
+            request.param))
+    return(file_path)
+
+@pytest.fixture(scope="module",
+                params=["307_302.poly"])
+def data_307_302(request, dir_geometry_generic):
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_generic,
+            request.param))
+    return(file_path)
+
 @pytest.fixture(scope="module",
                 params=["401.poly",
                         "401_1.poly",
@@ -363,6 +408,30 @@ def test_208(validate, data_208, solid):
     error = validate(data_208, options=solid)
     assert(error == [208])
 
+def test_104_geos(validate, data_104, solid_geos):
+    error = validate(data_104, options=solid_geos)
+    assert(error == [104])
+
+def test_201_geos(validate, data_201, solid_geos):
+    error = validate(data_201, options=solid_geos)
+    assert(error == [201])
+
+def test_205_geos(validate, data_205, solid_geos):
+    error = validate(data_205, options=solid_geos)
+    assert(error == [205])
+
+def test_206_geos(validate, data_206, solid_geos):
+    error = validate(data_206, options=solid_geos)
+    assert(error == [206] or error == [201])
+
+def test_207_geos(validate, data_207, solid_geos):
+    error = validate(data_207, options=solid_geos)
+    assert(error == [207])
+
+def test_208_geos(validate, data_208, solid_geos):
+    error = validate(data_208, options=solid_geos)
+    assert(error == [208])
+
 def test_301(validate, data_301, solid):
     error = validate(data_301, options=solid)
     assert(error == [301])
@@ -396,6 +465,33 @@ def test_307_1(validate, data_307_1, solid):
     error = validate(data_307_1, options=solid)
     assert(error == [307])
 
+#-- the errors of the shells with several defects, with their faces: the linear-time
+#-- check of the edges must report the same ones as the CGAL builder
+def test_302_two_holes(validate_errors, data_302_3, solid):
+    """A tube: 2 holes"""
+    error = validate_errors(data_302_3, options=solid)
+    assert(error == [(302, ""), (302, "")])
+
+def test_303_holes(validate_errors, data_303_302, solid):
+    """A tube with one face twice: only the 303 are reported, not the holes"""
+    error = validate_errors(data_303_302, options=solid)
+    assert(error == [(303, "4"), (303, "4")])
+
+def test_305_holes(validate_errors, data_305_302, solid):
+    """A tube and one square: one 305, the holes are not reported"""
+    error = validate_errors(data_305_302, options=solid)
+    assert(error == [(305, "")])
+
+def test_307_twice(validate_errors, data_307_2, solid):
+    """2 faces flipped, each face has 2 triangles"""
+    error = validate_errors(data_307_2, options=solid)
+    assert(error == [(307, "2"), (307, "2"), (307, "4"), (307, "4")])
+
+def test_307_hole(validate_errors, data_307_302, solid):
+    """No top face and one face flipped: only the 307 are reported"""
+    error = validate_errors(data_307_302, options=solid)
+    assert(error == [(307, "2"), (307, "2")])
+
 def test_401(validate, data_401, solid):
     error = validate(data_401, options=solid)
     assert(error == [401])
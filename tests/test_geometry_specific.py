@@ -31,6 +31,61 @@ def data_501_overlap(request, dir_geometry_specific):
     return(file_path)
 
 
+@pytest.fixture(scope="module",
+                params=["501_2.json"])
+def data_501_deep_overlap(request, dir_geometry_specific):
+    """2 cubes whose intersection is a cube of side 0.05"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
+@pytest.fixture(scope="module",
+                params=["501_3.json"])
+def data_501_convex(request, dir_geometry_specific):
+    """3 boxes: the 1st and 2nd overlap by 0.005, the 2nd and 3rd by 0.1"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
+@pytest.fixture(scope="module",
+                params=["501_4.json"])
+def data_501_convex_tol(request, dir_geometry_specific):
+    """2 boxes overlapping by 0.005"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
+@pytest.fixture(scope="module",
+                params=["501_5.json"])
+def data_501_pyramid(request, dir_geometry_specific):
+    """a square pyramid (4 planes meet at its apex) and a box overlapping it by 0.6"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
+@pytest.fixture(scope="module",
+                params=["501_6.json"])
+def data_501_pyramid_tol(request, dir_geometry_specific):
+    """a square pyramid and a box overlapping it by 0.005"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
 @pytest.fixture(scope="module",
                 params=["502.json"])
 def data_502(request, dir_geometry_specific):
@@ -51,6 +106,42 @@ def data_503(request, dir_geometry_specific):
     return(file_path)
 
 
+@pytest.fixture(scope="module",
+                params=["503_1.json",
+                        "503_2.json",
+                        "503_5.json"])
+def data_503_more(request, dir_geometry_specific):
+    """26 cubes around a void, 2 cubes in contact along an edge, and 6 boxes around 
+    a void whose faces are in contact only in part"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
+@pytest.fixture(scope="module",
+                params=["503_4.json"])
+def data_503_partial(request, dir_geometry_specific):
+    """a box whose face is in contact with the faces of 2 boxes"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
+@pytest.fixture(scope="module",
+                params=["503_3.json"])
+def data_503_gap(request, dir_geometry_specific):
+    """2 cubes with a gap of 0.005"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
 @pytest.fixture(scope="module",
                 params=["601.json",
                         "601_1.json"])
@@ -62,6 +153,39 @@ def data_601(request, dir_geometry_specific):
     return(file_path)
 
 
+@pytest.fixture(scope="module",
+                params=["601.json"])
+def data_601_deep_overlap(request, dir_geometry_specific):
+    """2 BuildingParts overlapping by 50 units"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
+@pytest.fixture(scope="module",
+                params=["601_2.json"])
+def data_601_convex(request, dir_geometry_specific):
+    """3 BuildingParts (boxes): the 1st and 2nd overlap by 0.005, the 2nd and 3rd by 0.1"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
+@pytest.fixture(scope="module",
+                params=["601_3.json"])
+def data_601_convex_tol(request, dir_geometry_specific):
+    """2 BuildingParts (boxes) overlapping by 0.005"""
+    file_path = os.path.abspath(
+        os.path.join(
+            dir_geometry_specific,
+            request.param))
+    return(file_path)
+
+
 @pytest.fixture(scope="module",
                 params=["601_1.json"])
 def data_601_overlap(request, dir_geometry_specific):
@@ -83,6 +207,36 @@ def options_overlap(request):
     return(request.param)
 
 
+@pytest.fixture(scope="module",
+                params=[
+                    ["--unittests", "--corefinement", "--overlap_tol 0.01"],
+                    ["--unittests", "--corefinement", "--overlap_tol 0.1"],
+                    ["--unittests", "--corefinement", "--overlap_tol 1.0"]
+                    ])
+def options_overlap_corefinement(request):
+    return(request.param)
+
+
+@pytest.fixture(scope="module",
+                params=[
+                    ["--unittests", "--overlap_distance", "--overlap_tol 0.01"],
+                    ["--unittests", "--overlap_distance", "--overlap_tol 0.1"],
+                    ["--unittests", "--overlap_distance", "--overlap_tol 1.0"]
+                    ])
+def options_overlap_distance(request):
+    return(request.param)
+
+
+@pytest.fixture(scope="module",
+                params=[
+                    ["--unittests", "--overlap_tol 0.01"],
+                    ["--unittests", "--corefinement", "--overlap_tol 0.01"],
+                    ["--unittests", "--overlap_distance", "--overlap_tol 0.01"]
+                    ])
+def options_overlap_small(request):
+    return(request.param)
+
+
 #----------------------------------------------------------------------- Tests
 
 def test_501(validate, data_501, unittests):
@@ -93,6 +247,50 @@ def test_501_overlap(validate, data_501_overlap, options_overlap):
     error = validate(data_501_overlap, options=options_overlap)
     assert(error == [])
 
+def test_501_corefinement(validate, data_501, corefinement):
+    error = validate(data_501, options=corefinement)
+    assert(error == [501])
+
+def test_501_overlap_corefinement(validate, data_501_overlap, options_overlap_corefinement):
+    error = validate(data_501_overlap, options=options_overlap_corefinement)
+    assert(error == [])
+
+def test_501_deep_overlap(validate, data_501_deep_overlap, unittests):
+    error = validate(data_501_deep_overlap, options=unittests + ["--overlap_tol 0.01"])
+    assert(error == [501])
+
+def test_501_deep_overlap_corefinement(validate, data_501_deep_overlap, corefinement):
+    error = validate(data_501_deep_overlap, options=corefinement + ["--overlap_tol 0.01"])
+    assert(error == [501])
+
+def test_501_deep_overlap_corefinement_tol(validate, data_501_deep_overlap, corefinement):
+    error = validate(data_501_deep_overlap, options=corefinement + ["--overlap_tol 0.1"])
+    assert(error == [])
+
+def test_501_overlap_distance(validate, data_501_overlap, options_overlap_distance):
+    error = validate(data_501_overlap, options=options_overlap_distance)
+    assert(error == [])
+
+def test_501_deep_overlap_distance(validate, data_501_deep_overlap):
+    error = validate(data_501_deep_overlap, options=["--unittests", "--overlap_distance", "--overlap_tol 0.01"])
+    assert(error == [501])
+
+def test_501_convex(validate, data_501_convex, options_overlap_small):
+    error = validate(data_501_convex, options=options_overlap_small)
+    assert(error == [501])
+
+def test_501_convex_tol(validate, data_501_convex_tol, options_overlap_small):
+    error = validate(data_501_convex_tol, options=options_overlap_small)
+    assert(error == [])
+
+def test_501_pyramid(validate, data_501_pyramid, options_overlap_small):
+    error = validate(data_501_pyramid, options=options_overlap_small)
+    assert(error == [501])
+
+def test_501_pyramid_tol(validate, data_501_pyramid_tol, options_overlap_small):
+    error = validate(data_501_pyramid_tol, options=options_overlap_small)
+    assert(error == [])
+
 def test_502(validate, data_502, unittests):
     error = validate(data_502, options=unittests)
     assert(error == [502])
@@ -101,10 +299,50 @@ def test_503(validate, data_503, unittests):
     error = validate(data_503, options=unittests)
     assert(error == [503])
 
+def test_503_more(validate, data_503_more, unittests):
+    error = validate(data_503_more, options=unittests)
+    assert(error == [503])
+
+def test_503_more_overlap(validate, data_503_more, options_overlap_small):
+    error = validate(data_503_more, options=options_overlap_small)
+    assert(error == [503])
+
+def test_503_partial(validate, data_503_partial, unittests):
+    error = validate(data_503_partial, options=unittests)
+    assert(error == [])
+
+def test_503_gap(validate, data_503_gap, unittests):
+    error = validate(data_503_gap, options=unittests)
+    assert(error == [503])
+
+def test_503_gap_overlap(validate, data_503_gap, options_overlap_small):
+    error = validate(data_503_gap, options=options_overlap_small)
+    assert(error == [])
+
 def test_601(validate, data_601, unittests):
     error = validate(data_601, options=unittests)
     assert(error == [601])
 
+def test_601_threads(validate, data_601):
+    error = validate(data_601, options=["--unittests", "--overlap_threads 4"])
+    assert(error == [601])
+
+def test_601_convex(validate, data_601_convex, options_overlap_small):
+    error = validate(data_601_convex, options=options_overlap_small)
+    assert(error == [601])
+
+def test_601_convex_tol(validate, data_601_convex_tol, options_overlap_small):
+    error = validate(data_601_convex_tol, options=options_overlap_small)
+    assert(error == [])
+
 def test_601_overlap(validate, data_601_overlap, options_overlap):
     error = validate(data_601_overlap, options=options_overlap)
-    assert(error == [])
\ No newline at end of file
+    assert(error == [])
+
+def test_601_overlap_distance(validate, data_601_overlap, options_overlap_distance):
+    error = validate(data_601_overlap, options=options_overlap_distance)
+    assert(error == [])
+
+def test_601_deep_overlap_distance(validate, data_601_deep_overlap, options_overlap_distance):
+    error = validate(data_601_deep_overlap, options=options_overlap_distance)
+    assert(error == [601])
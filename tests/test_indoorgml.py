@@ -65,6 +65,23 @@ def data_igml_704(request, dir_indoorgml):
     return([file_path])
 
 
+@pytest.fixture(scope="module",
+                params=[
+                    ["--unittests", "--overlap_tol 0.01"],
+                    ["--unittests", "--overlap_distance", "--overlap_tol 0.01"]
+                    ])
+def options_overlap_small(request):
+    return(request.param)
+
+@pytest.fixture(scope="module",
+                params=[
+                    ["--unittests", "--overlap_tol 1.5"],
+                    ["--unittests", "--overlap_distance", "--overlap_tol 1.5"]
+                    ])
+def options_overlap_large(request):
+    return(request.param)
+
+
 #----------------------------------------------------------------------- Tests
 def test_valid_indoorgml(validate, data_igml_valid, unittests):
     error = validate(data_igml_valid, options=unittests)
@@ -88,4 +105,19 @@ def test_igml_704(validate, data_igml_704, unittests):
 
 def test_igml_704(validate, data_igml_704_valid, unittests):
     error = validate(data_igml_704_valid, options=unittests)
-    assert(error == [])      
\ No newline at end of file
+    assert(error == [])      
+
+def test_igml_704_valid_overlap(validate, data_igml_704_valid, options_overlap_small):
+    """Cells in contact are adjacent with a tolerance"""
+    error = validate(data_igml_704_valid, options=options_overlap_small)
+    assert(error == [])
+
+def test_igml_704_overlap(validate, data_igml_704, options_overlap_small):
+    """Cells 1 unit apart are not adjacent with a tolerance of 0.01"""
+    error = validate(data_igml_704, options=options_overlap_small)
+    assert(error == [704])
+
+def test_igml_704_overlap_large(validate, data_igml_704, options_overlap_large):
+    """Cells 1 unit apart are adjacent with a tolerance of 1.5"""
+    error = validate(data_igml_704, options=options_overlap_large)
+    assert(error == [])